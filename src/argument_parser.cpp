@@ -112,7 +112,7 @@ Arguments::Arguments(const int argc, const char* argv[], predefined_args_t prede
         else if (this_arg[0] == '-' && this_arg.size() != 1)
         {
             // Handle argument with key
-            replace_all(this_arg, "-", ""); // Remove leading '-'
+            this_arg.erase(0, this_arg.find_first_not_of('-')); // Remove leading '-', keep the ones inside names
 
             if (this_arg.find('=') != std::string::npos)
             {
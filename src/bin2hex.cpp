@@ -19,68 +19,106 @@
  */
 
 #include "bin2hex.h"
-#include "log.hpp"
 
+#include <algorithm>
 #include <stdexcept>
 
-constexpr int max_line_char_num = 64;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+# include <immintrin.h>
+# define BIN2HEX_SSSE3
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+# include <arm_neon.h>
+# define BIN2HEX_NEON
+#endif
 
 namespace bin2hex {
-    char hex_table [] = {
-        '0', 0x00,
-        '1', 0x01,
-        '2', 0x02,
-        '3', 0x03,
-        '4', 0x04,
-        '5', 0x05,
-        '6', 0x06,
-        '7', 0x07,
-        '8', 0x08,
-        '9', 0x09,
-        'a', 0x0A,
-        'b', 0x0B,
-        'c', 0x0C,
-        'd', 0x0D,
-        'e', 0x0E,
-        'f', 0x0F,
-    };
+    namespace {
+        constexpr size_t vector_threshold = 64; // below this the table is as fast
 
-    void c_bin2hex(const char bin, char hex[2])
-    {
-        auto find_in_table = [](const char p_hex) -> char {
-            for (size_t i = 0; i < sizeof(hex_table); i += 2) {
-                if (hex_table[i + 1] == p_hex) {
-                    return hex_table[i];
-                }
+#ifdef BIN2HEX_SSSE3
+        // split every byte into its nibbles, look both up with pshufb, interleave high nibble first
+        __attribute__((target("ssse3")))
+        size_t encode_ssse3(const uint8_t * bin, const size_t length, char * out)
+        {
+            const __m128i digits = _mm_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                                 '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+            const __m128i low_mask = _mm_set1_epi8(0x0F);
+            size_t i = 0;
+            for (; i + 16 <= length; i += 16)
+            {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(bin + i));
+                const __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), low_mask));
+                const __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, low_mask));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i), _mm_unpacklo_epi8(high, low));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 16), _mm_unpackhi_epi8(high, low));
             }
+            return i;
+        }
+
+        const bool has_ssse3 = __builtin_cpu_supports("ssse3");
+#endif // BIN2HEX_SSSE3
+
+#ifdef BIN2HEX_NEON
+        size_t encode_neon(const uint8_t * bin, const size_t length, char * out)
+        {
+            static constexpr uint8_t digit_bytes[16] = { '0', '1', '2', '3', '4', '5', '6', '7',
+                                                         '8', '9', 'a', 'b', 'c', 'd', 'e', 'f' };
+            const uint8x16_t digits = vld1q_u8(digit_bytes);
+            size_t i = 0;
+            for (; i + 16 <= length; i += 16)
+            {
+                const uint8x16_t bytes = vld1q_u8(bin + i);
+                uint8x16x2_t pairs;
+                pairs.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(bytes, 4));
+                pairs.val[1] = vqtbl1q_u8(digits, vandq_u8(bytes, vdupq_n_u8(0x0F)));
+                vst2q_u8(reinterpret_cast<uint8_t *>(out + 2 * i), pairs);
+            }
+            return i;
+        }
+#endif // BIN2HEX_NEON
+    }
 
-            throw std::invalid_argument("Invalid binary code");
-        };
+    size_t encode(const std::span < const uint8_t > bin, const std::span < char > out)
+    {
+        if (out.size() / 2 < bin.size()) {
+            throw std::invalid_argument("Hex output buffer too small");
+        }
 
-        const char bin_a = static_cast<char>(bin >> 4) & 0x0F;
-        const char bin_b = bin & 0x0F;
+        size_t done = 0;
+        if (bin.size() >= vector_threshold)
+        {
+#if defined(BIN2HEX_SSSE3)
+            if (has_ssse3) {
+                done = encode_ssse3(bin.data(), bin.size(), out.data());
+            }
+#elif defined(BIN2HEX_NEON)
+            done = encode_neon(bin.data(), bin.size(), out.data());
+#endif
+        }
 
-        hex[0] = find_in_table(bin_a);
-        hex[1] = find_in_table(bin_b);
+        encode(bin.subspan(done), out.data() + 2 * done);
+        return 2 * bin.size();
     }
 
-    std::string bin2hex(const std::vector < char > & vec)
+    std::string bin2hex(const std::span < const uint8_t > bin, const size_t line_length)
     {
-        int cur_line_char_num = 0;
+        std::string hex(2 * bin.size(), '\0');
+        encode(bin, std::span(hex));
+        if (line_length == 0) {
+            return hex;
+        }
 
+        // one pass moving every line into place, a line break after each full one
         std::string result;
-        char buffer [3] { };
-        for (const auto & bin : vec) {
-            c_bin2hex(bin, buffer);
-            result += buffer;
-            cur_line_char_num += 2;
-
-            if (cur_line_char_num == max_line_char_num) {
-                result += "\n";
-                cur_line_char_num = 0;
+        result.reserve(hex.size() + hex.size() / line_length);
+        for (size_t i = 0; i < hex.size(); i += line_length)
+        {
+            const size_t length = std::min(line_length, hex.size() - i);
+            result.append(hex, i, length);
+            if (length == line_length) {
+                result += '\n';
             }
         }
-
         return result;
     }
 }
@@ -26,16 +26,33 @@
 #include "log.hpp"
 #include "argument_parser.h"
 #include "bin2hex.h"
+#include "crc64.h"
+#include "thread_pool.h"
+#include "file_reader.h"
+#include "checksum_cache.h"
+#include "checksum_xattr.h"
+#include "directory_walker.h"
+#include "manifest.h"
+#include "output_writer.h"
+#include "digest.h"
+#include "stats.h"
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <vector>
 #include <stdexcept>
-#include <array>
 #include <fstream>
 #include <iostream>
 #include <memory>
 #include <locale>
 #include <cstring>
+#include <future>
+#include <exception>
+#include <cerrno>
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <filesystem>
 
 #ifdef WIN32
 # include <io.h>
@@ -86,57 +103,6 @@ bool is_dir(const char * path) {
 #endif
 }
 
-enum endian_t { LITTLE_ENDIAN, BIG_ENDIAN };
-
-class CRC64 {
-public:
-    CRC64() {
-        init_crc64();
-    }
-
-    void update(const uint8_t* data, const size_t length) {
-        for (size_t i = 0; i < length; ++i) {
-            crc64_value = table[(crc64_value ^ data[i]) & 0xFF] ^ (crc64_value >> 8);
-        }
-    }
-
-    [[nodiscard]] uint64_t get_checksum(const endian_t endian = BIG_ENDIAN
-        /* CRC64 tools like 7ZIP display in BIG_ENDIAN */) const
-    {
-        // add the final complement that ECMA‑182 requires
-        return (endian == BIG_ENDIAN
-            ? reverse_bytes(crc64_value ^ 0xFFFFFFFFFFFFFFFFULL)
-            : (crc64_value ^ 0xFFFFFFFFFFFFFFFFULL));
-    }
-
-private:
-    uint64_t crc64_value{};
-    uint64_t table[256] {};
-
-    void init_crc64()
-    {
-        crc64_value = 0xFFFFFFFFFFFFFFFF;
-        for (uint64_t i = 0; i < 256; ++i) {
-            uint64_t crc = i;
-            for (uint64_t j = 8; j--; ) {
-                if (crc & 1)
-                    crc = (crc >> 1) ^ 0xC96C5795D7870F42;  // Standard CRC-64 polynomial
-                else
-                    crc >>= 1;
-            }
-            table[i] = crc;
-        }
-    }
-
-    static uint64_t reverse_bytes(uint64_t x)
-    {
-        x = ((x & 0x00000000FFFFFFFFULL) << 32) | ((x & 0xFFFFFFFF00000000ULL) >> 32);
-        x = ((x & 0x0000FFFF0000FFFFULL) << 16) | ((x & 0xFFFF0000FFFF0000ULL) >> 16);
-        x = ((x & 0x00FF00FF00FF00FFULL) << 8)  | ((x & 0xFF00FF00FF00FF00ULL) >> 8);
-        return x;
-    }
-};
-
 Arguments::predefined_args_t arguments = {
     Arguments::single_arg_t {
         .name = "checksum",
@@ -156,6 +122,12 @@ Arguments::predefined_args_t arguments = {
         .value_required = true,
         .explanation = "Endianness, acceptable options are little or big (default)"
     },
+    Arguments::single_arg_t {
+        .name = "algorithm",
+        .short_name = 'A',
+        .value_required = true,
+        .explanation = "CRC-64 variant, acceptable options are xz (default), ecma-182, go-iso or nvme"
+    },
     Arguments::single_arg_t {
         .name = "help",
         .short_name = 'h',
@@ -174,6 +146,120 @@ Arguments::predefined_args_t arguments = {
         .value_required = false,
         .explanation = "Disable color codes and UTF-8 codes"
     },
+    Arguments::single_arg_t {
+        .name = "threads",
+        .short_name = 't',
+        .value_required = true,
+        .explanation = "Hash large regular files in N parallel ranges (0 means one per CPU)"
+    },
+    Arguments::single_arg_t {
+        .name = "jobs",
+        .short_name = 'j',
+        .value_required = true,
+        .explanation = "Hash N files at once, output keeps the command line order (0 means one per CPU)"
+    },
+    Arguments::single_arg_t {
+        .name = "io",
+        .short_name = 'i',
+        .value_required = true,
+        .explanation = "I/O engine for regular files, acceptable options are mmap (default), uring, direct or stream"
+    },
+    Arguments::single_arg_t {
+        .name = "queue-depth",
+        .short_name = 'q',
+        .value_required = true,
+        .explanation = "Number of reads the uring engine keeps in flight (default 32)"
+    },
+    Arguments::single_arg_t {
+        .name = "block-size",
+        .short_name = 'b',
+        .value_required = true,
+        .explanation = "Size of each read, with an optional K, M or G suffix (default 1M)"
+    },
+    Arguments::single_arg_t {
+        .name = "tee",
+        .short_name = 'T',
+        .value_required = false,
+        .explanation = "Copy STDIN to STDOUT unchanged while hashing it, the checksum goes to STDERR"
+    },
+    Arguments::single_arg_t {
+        .name = "cache",
+        .short_name = 'C',
+        .value_required = true,
+        .explanation = "Reuse checksums kept in this cache file for files whose size and mtime are unchanged"
+    },
+    Arguments::single_arg_t {
+        .name = "force",
+        .short_name = 'F',
+        .value_required = false,
+        .explanation = "Hash every file again and refresh its cache entry"
+    },
+    Arguments::single_arg_t {
+        .name = "xattr",
+        .short_name = 'x',
+        .value_required = true,
+        .explanation = "Checksums in the user.crc64 attribute, acceptable options are ignore (default), trust or populate"
+    },
+    Arguments::single_arg_t {
+        .name = "recursive",
+        .short_name = 'r',
+        .value_required = false,
+        .explanation = "Hash every regular file below directories, sorted by path"
+    },
+    Arguments::single_arg_t {
+        .name = "follow-symlinks",
+        .short_name = 'L',
+        .value_required = false,
+        .explanation = "Follow symbolic links below directories in recursive mode"
+    },
+    Arguments::single_arg_t {
+        .name = "one-file-system",
+        .short_name = 'X',
+        .value_required = false,
+        .explanation = "Stay on the file system of each directory in recursive mode"
+    },
+    Arguments::single_arg_t {
+        .name = "manifest",
+        .short_name = 'M',
+        .value_required = true,
+        .explanation = "Also write the checksums to this binary manifest, which --checksum accepts as well"
+    },
+    Arguments::single_arg_t {
+        .name = "import",
+        .short_name = 'I',
+        .value_required = false,
+        .explanation = "Convert the checksum files given into the binary manifest named by --manifest"
+    },
+    Arguments::single_arg_t {
+        .name = "export",
+        .short_name = 'E',
+        .value_required = false,
+        .explanation = "Print the binary manifests given in the checksum file format"
+    },
+    Arguments::single_arg_t {
+        .name = "only",
+        .short_name = 'o',
+        .value_required = true,
+        .explanation = "Only verify this file from the checksum files, or everything below it if it ends with /"
+    },
+    Arguments::single_arg_t {
+        .name = "line-buffered",
+        .short_name = 'l',
+        .value_required = false,
+        .explanation = "Flush output after every line, the default when writing to a terminal"
+    },
+    Arguments::single_arg_t {
+        .name = "digest",
+        .short_name = 'D',
+        .value_required = true,
+        .explanation = "Also print these digests, read in the same pass, acceptable options are crc32c and xxh64"
+    },
+    Arguments::single_arg_t {
+        .name = "stats",
+        .short_name = 'S',
+        .value_required = true,
+        .explanation = "Print I/O, hashing and latency statistics to STDERR at exit and on SIGUSR1, as text or json"
+    },
 };
 
 void replace_all(std::string&, const std::string&, const std::string&);
@@ -181,17 +267,255 @@ std::string getEnvVar(const std::string &);
 
 endian_t endian;
 bool disable_all_bullshit_codes = false;
-bool general_error = false;
+thread_local bool general_error = false;
+file_reader::options_t io_options;
+bool tee_stdin = false;
+
+// files are only split when every range gets at least this much
+constexpr uint64_t min_range_size = 16 * 1024 * 1024;
+std::unique_ptr<ThreadPool> range_pool;
+std::unique_ptr<ChecksumCache> checksum_cache;
+bool force_rehash = false;
+checksum_xattr::mode_t xattr_mode = checksum_xattr::IGNORE;
+std::vector<digest::kind_t> extra_digests;
+
+// buffers are handed to every digest a slice at a time, so the later ones read it from cache
+constexpr size_t digest_slice_size = 64 * 1024;
+// largest buffer counted at once by --stats
+constexpr size_t stats_slice_size = 16 * 1024 * 1024;
+
+/*
+ * With --stats, time spent in the consumer counts as hashing and the gaps before each call as waiting for I/O,
+ * finish() adds the wait for the end of the input after the last buffer. Mapped windows are handed over in
+ * slices, so SIGUSR1 reports progress within them.
+ */
+class InstrumentedConsumer {
+private:
+    file_reader::consumer_t consumer;
+    uint64_t last;
+
+public:
+    explicit InstrumentedConsumer(file_reader::consumer_t consumer_)
+        : consumer(std::move(consumer_)), last(stats::enabled() ? stats::now_ns() : 0) { }
+
+    // the consumer to read into, it refers to this object
+    file_reader::consumer_t get()
+    {
+        if (!stats::enabled()) {
+            return consumer;
+        }
+
+        return [this](const uint8_t * data, size_t length)
+        {
+            do {
+                const size_t slice = std::min(length, stats_slice_size);
+                const uint64_t start = stats::now_ns();
+                consumer(data, slice);
+                const uint64_t end = stats::now_ns();
+                stats::count_chunk(slice, start - last, end - start);
+                last = end;
+                data += slice;
+                length -= slice;
+            } while (length != 0);
+        };
+    }
+
+    void finish()
+    {
+        if (stats::enabled()) {
+            stats::count_chunk(0, stats::now_ns() - last, 0);
+        }
+    }
+};
+
+// read [offset, offset + length) of a regular file into consumer with the configured engine
+void read_an_extent(const std::string & filename, const uint64_t offset, const uint64_t length,
+    const file_reader::consumer_t & consumer)
+{
+    InstrumentedConsumer instrumented(consumer);
+    if (file_reader::read_regular_file(io_options, filename, offset, length, instrumented.get())) {
+        instrumented.finish();
+        return;
+    }
+
+    std::ifstream file_stream(filename, std::ios::in | std::ios::binary);
+    if (!file_stream) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+
+    file_stream.seekg(static_cast<std::streamoff>(offset));
+    if (file_reader::read_stream(file_stream, instrumented.get(), io_options.block_size, length) != length) {
+        throw std::runtime_error("Cannot read file: " + filename);
+    }
+    instrumented.finish();
+}
+
+// feed crc64 and the --digest digests from the same buffers
+file_reader::consumer_t fan_out(CRC64 & crc64, digest::Extras & extras)
+{
+    if (extras.empty()) {
+        return [&crc64](const uint8_t * data, const size_t length) { crc64.update(data, length); };
+    }
 
+    return [&crc64, &extras](const uint8_t * data, size_t length)
+    {
+        while (length != 0)
+        {
+            const size_t slice = std::min(length, digest_slice_size);
+            crc64.update(data, slice);
+            extras.update(data, slice);
+            data += slice;
+            length -= slice;
+        }
+    };
+}
+
+// holes of sparse files are accounted for as runs of zeros, without reading them
+CRC64 hash_a_range(const std::string & filename, const uint64_t offset, const uint64_t length)
+{
+    CRC64 crc64;
+    if (!file_reader::for_each_extent(filename, offset, length,
+            [&](const uint64_t data_offset, const uint64_t data_length) {
+                read_an_extent(filename, data_offset, data_length,
+                    [&crc64](const uint8_t * data, const size_t size) { crc64.update(data, size); });
+            },
+            [&crc64](const uint64_t hole_length) { crc64.update_zeros(hole_length); }))
+    {
+        read_an_extent(filename, offset, length,
+            [&crc64](const uint8_t * data, const size_t size) { crc64.update(data, size); });
+    }
+
+    return crc64;
+}
+
+// hash ranges of a regular file on range_pool and stitch them together with CRC64::combine
+CRC64 hash_file_in_ranges(const std::string & filename, const uint64_t file_size)
+{
+    const uint64_t range_count = std::min<uint64_t>(range_pool->size(), file_size / min_range_size);
+    const uint64_t range_size = file_size / range_count;
+
+    std::vector < std::pair < std::future < CRC64 >, uint64_t > > ranges;
+    for (uint64_t i = 0; i < range_count; ++i)
+    {
+        const uint64_t offset = i * range_size;
+        const uint64_t length = (i == range_count - 1) ? file_size - offset : range_size;
+        ranges.emplace_back(range_pool->submit([filename, offset, length] {
+            return hash_a_range(filename, offset, length);
+        }), length);
+    }
+
+    CRC64 crc64 = ranges.front().first.get();
+    for (auto it = ranges.begin() + 1; it != ranges.end(); ++it) {
+        crc64.combine(it->first.get(), it->second);
+    }
+
+    return crc64;
+}
+
+// the checksum cache and the user.crc64 attribute keep checksums in little endian byte order
+uint64_t in_output_endian(const uint64_t checksum)
+{
+    return endian == LITTLE_ENDIAN ? checksum : CRC64::reverse_bytes(checksum);
+}
+
+int64_t now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool remembers_checksums()
+{
+    return checksum_cache || xattr_mode != checksum_xattr::IGNORE;
+}
+
+// checksum of an unchanged file from the user.crc64 attribute or the checksum cache
+bool recall_checksum(const std::string & filename, const ChecksumCache::file_key_t & key, uint64_t & checksum)
+{
+    if (!force_rehash && xattr_mode == checksum_xattr::TRUST && checksum_xattr::load(filename, key, checksum)) {
+        return true;
+    }
+
+    if (!checksum_cache) {
+        return false;
+    }
+
+    if (force_rehash) {
+        checksum_cache->count_miss();
+        return false;
+    }
+
+    if (!checksum_cache->lookup(key, checksum)) {
+        return false;
+    }
+
+    if (xattr_mode == checksum_xattr::POPULATE && !checksum_xattr::store(filename, key, checksum)) {
+        debug::log(debug::to_stderr, debug::warning_log, "Cannot store checksum in attributes of ", filename, "\n");
+    }
+    return true;
+}
+
+// keep a checksum computed from reading started on in the cache and the user.crc64 attribute
+void remember_checksum(const std::string & filename, const ChecksumCache::file_key_t & key,
+    const int64_t started, const uint64_t checksum)
+{
+    // skip files that changed while being read, or that could still change within the same
+    // timestamp tick, those could be served stale later
+    constexpr int64_t timestamp_granularity = 1000000000;
+    if (ChecksumCache::file_key_t after { };
+        !ChecksumCache::file_key(filename, after) || after != key || key.mtime_ns + timestamp_granularity >= started)
+    {
+        return;
+    }
+
+    if (checksum_cache) {
+        checksum_cache->store(key, checksum);
+    }
+
+    if (xattr_mode == checksum_xattr::POPULATE && !checksum_xattr::store(filename, key, checksum)) {
+        debug::log(debug::to_stderr, debug::warning_log, "Cannot store checksum in attributes of ", filename, "\n");
+    }
+}
+
+// hash a non-empty regular file, through the checksum cache and the user.crc64 attribute when enabled
+uint64_t hash_a_regular_file(const std::string & filename, const uint64_t file_size)
+{
+    auto hash = [&filename, file_size]()->CRC64 {
+        if (range_pool && file_size >= 2 * min_range_size) {
+            return hash_file_in_ranges(filename, file_size);
+        }
+        return hash_a_range(filename, 0, file_size);
+    };
+
+    ChecksumCache::file_key_t key { };
+    if (!remembers_checksums() || !ChecksumCache::file_key(filename, key)) {
+        return hash().get_checksum(endian);
+    }
+
+    uint64_t checksum = 0;
+    if (recall_checksum(filename, key, checksum)) {
+        return in_output_endian(checksum);
+    }
+
+    const auto started = now_ns();
+    checksum = hash().get_checksum(LITTLE_ENDIAN);
+    remember_checksum(filename, key, started, checksum);
+    return in_output_endian(checksum);
+}
+
+// digests receives the --digest values, in the order they were asked for
 #ifndef WIN32
-uint64_t hash_a_file(std::string filename)
+uint64_t hash_a_file(std::string filename, std::vector<uint64_t> & digests)
 {
     replace_all(filename, "\\", "/");
 #else
-uint64_t hash_a_file(const std::string& filename)
+uint64_t hash_a_file(const std::string& filename, std::vector<uint64_t> & digests)
 {
     DWORD originalMode { };
 #endif
+    CRC64 crc64;
+    digest::Extras extras(extra_digests);
+    const auto feed = fan_out(crc64, extras);
     std::unique_ptr<std::istream> file_stream;
     if (filename != "STDIN")
     {
@@ -199,8 +523,35 @@ uint64_t hash_a_file(const std::string& filename)
             general_error = true;
             return 0;
         }
+
+        uint64_t file_size = 0;
+        const bool regular_file = file_reader::regular_file_size(filename, file_size);
+        // zero-sized ones can still have content (procfs), those are streamed until EOF below
+        if (regular_file && file_size != 0 && extras.empty()) {
+            return hash_a_regular_file(filename, file_size);
+        }
+
+        // other digests can neither be split into ranges nor skip holes, one sequential read feeds them all
+        if (regular_file && file_size != 0) {
+            read_an_extent(filename, 0, file_size, feed);
+            digests = extras.values();
+            return crc64.get_checksum(endian);
+        }
+
         file_stream = std::make_unique<std::ifstream>(filename, std::ios::in | std::ios::binary);
     } else {
+#ifdef __unix__
+        // raw read(2) on the descriptor, iostream would only add copies
+        InstrumentedConsumer instrumented(feed);
+        const auto size = file_reader::read_descriptor(STDIN_FILENO, instrumented.get(),
+            io_options.block_size, tee_stdin ? STDOUT_FILENO : -1);
+        instrumented.finish();
+        if (size == 0) {
+            debug::log(debug::to_stderr, debug::warning_log, filename + " is an empty file.\n");
+        }
+        digests = extras.values();
+        return crc64.get_checksum(endian);
+#else
         file_stream = std::make_unique<std::istream>(std::cin.rdbuf());
 #ifdef WIN32
 # ifdef __DEBUG__
@@ -220,29 +571,29 @@ uint64_t hash_a_file(const std::string& filename)
             }
         }
 #endif
+#endif // __unix__
     }
 
     if (!file_stream || !*file_stream) {
         throw std::runtime_error("Could not open file: " + filename);
     }
 
-    std::array <uint8_t, 4 * 1024> buffer{};
-    CRC64 crc64;
-    do
+    InstrumentedConsumer instrumented([&feed, &filename](const uint8_t * data, const size_t length)
     {
-        file_stream->read(reinterpret_cast<char *>(buffer.data()), buffer.size());
-        const auto size = file_stream->gcount();
-        if (size < 0)
-        {
-            throw std::runtime_error("Cannot read file: " + filename);
-        }
-
-        if (size == 0 && crc64.get_checksum(LITTLE_ENDIAN) == 0x00) {
-            debug::log(debug::to_stderr, debug::warning_log, filename + " is an empty file.\n");
+        feed(data, length);
+        if (tee_stdin && filename == "STDIN") {
+            std::cout.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(length));
         }
+    });
+    const auto size = file_reader::read_stream(*file_stream, instrumented.get(), io_options.block_size);
+    instrumented.finish();
+    if (file_stream->bad()) {
+        throw std::runtime_error("Cannot read file: " + filename);
+    }
 
-        crc64.update(buffer.data(), size);
-    } while (*file_stream);
+    if (size == 0) {
+        debug::log(debug::to_stderr, debug::warning_log, filename + " is an empty file.\n");
+    }
 
     if (filename == "STDIN")
     {
@@ -258,9 +609,225 @@ uint64_t hash_a_file(const std::string& filename)
 #endif
     }
 
+    digests = extras.values();
     return crc64.get_checksum(endian);
 }
 
+// outcome of hash_a_file, carried from a worker thread back to whoever prints it
+struct file_hash_t {
+    uint64_t checksum = 0;
+    std::vector<uint64_t> digests;
+    bool skipped = false;
+    std::exception_ptr error;
+    int error_number = 0;
+};
+
+file_hash_t hash_a_file_captured(const std::string & filename)
+{
+    file_hash_t result;
+    const uint64_t started = stats::enabled() ? stats::now_ns() : 0;
+    try {
+        result.checksum = hash_a_file(filename, result.digests);
+        result.skipped = general_error;
+        general_error = false;
+    } catch (...) {
+        result.error = std::current_exception();
+        result.error_number = errno; // errno is per thread, keep it for the error message
+    }
+
+    if (stats::enabled()) {
+        stats::count_file(stats::now_ns() - started);
+    }
+    return result;
+}
+
+/*
+ * Hash many files on a pool, sized up front: large regular files are split into ranges of about one work
+ * unit, so none of them is left running alone at the end, and the remaining files are packed into
+ * batches of roughly one unit, so tiny ones do not each pay a handoff. Units are queued in command line
+ * order and sink() is called on this thread in that order, as soon as everything before a file is done.
+ * If sink() throws, units still queued return without hashing.
+ */
+void hash_files_scheduled(ThreadPool & pool, const std::vector < std::string > & filenames,
+    const std::function < void(const std::string &, const file_hash_t &) > & sink)
+{
+    // a range of a large file, errors are kept for the whole file
+    struct range_hash_t {
+        CRC64 crc64;
+        std::exception_ptr error;
+        int error_number = 0;
+    };
+
+    struct file_plan_t {
+        uint64_t size = 0;
+        bool split = false;
+        ChecksumCache::file_key_t key { };
+        bool has_key = false;
+        int64_t started = 0;
+        uint64_t dispatched_ns = 0;     // for --stats
+        std::optional < uint64_t > recalled;
+        std::vector < std::pair < std::future < range_hash_t >, uint64_t > > ranges;
+        std::shared_future < std::vector < file_hash_t > > batch;
+        size_t batch_index = 0;
+    };
+
+    // queued tasks outlive this function if sink() throws
+    const auto names = std::make_shared < const std::vector < std::string > >(filenames);
+    const auto cancelled = std::make_shared < std::atomic < bool > >(false);
+    std::vector < file_plan_t > plans(filenames.size());
+    uint64_t total_size = 0;
+    for (size_t i = 0; i < filenames.size(); ++i)
+    {
+        // non-regular files and STDIN count as empty, hash_a_file deals with them
+        auto & plan = plans[i];
+        if (filenames[i] == "STDIN" || !file_reader::regular_file_size(filenames[i], plan.size)) {
+            plan.size = 0;
+        }
+
+        total_size += plan.size;
+        plan.split = extra_digests.empty() && plan.size >= 2 * min_range_size;
+    }
+
+    // aim for a few units of work per worker, but never ranges below min_range_size
+    const uint64_t unit = std::max<uint64_t>(min_range_size, total_size / (pool.size() * 4));
+    constexpr size_t max_batch_files = 64;
+    std::vector < size_t > batch;
+    uint64_t batch_size = 0;
+    auto submit_batch = [&]
+    {
+        if (batch.empty()) {
+            return;
+        }
+
+        std::shared_future < std::vector < file_hash_t > > future = pool.submit([names, cancelled, batch] {
+            std::vector < file_hash_t > results;
+            results.reserve(batch.size());
+            for (const auto index : batch)
+            {
+                if (cancelled->load(std::memory_order_relaxed)) {
+                    break;
+                }
+                results.push_back(hash_a_file_captured((*names)[index]));
+            }
+            return results;
+        }).share();
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            plans[batch[i]].batch = future;
+            plans[batch[i]].batch_index = i;
+        }
+        batch.clear();
+        batch_size = 0;
+    };
+
+    for (size_t index = 0; index < filenames.size(); ++index)
+    {
+        auto & plan = plans[index];
+        if (!plan.split)
+        {
+            batch.push_back(index);
+            batch_size += plan.size;
+            if (batch.size() == max_batch_files || batch_size >= unit) {
+                submit_batch();
+            }
+            continue;
+        }
+
+        // keep the queue in command line order
+        submit_batch();
+        const auto & filename = filenames[index];
+        plan.dispatched_ns = stats::enabled() ? stats::now_ns() : 0;
+        if (remembers_checksums() && ChecksumCache::file_key(filename, plan.key))
+        {
+            plan.has_key = true;
+            if (uint64_t checksum = 0; recall_checksum(filename, plan.key, checksum)) {
+                plan.recalled = checksum;
+                if (stats::enabled()) {
+                    stats::count_file(stats::now_ns() - plan.dispatched_ns);
+                }
+                continue;
+            }
+            plan.started = now_ns();
+        }
+
+        const uint64_t range_count = std::max<uint64_t>(plan.size / unit, 1);
+        const uint64_t range_size = plan.size / range_count;
+        for (uint64_t i = 0; i < range_count; ++i)
+        {
+            const uint64_t offset = i * range_size;
+            const uint64_t length = (i == range_count - 1) ? plan.size - offset : range_size;
+            plan.ranges.emplace_back(pool.submit([names, cancelled, index, offset, length] {
+                range_hash_t result;
+                if (cancelled->load(std::memory_order_relaxed)) {
+                    return result;
+                }
+
+                try {
+                    result.crc64 = hash_a_range((*names)[index], offset, length);
+                } catch (...) {
+                    result.error = std::current_exception();
+                    result.error_number = errno;
+                }
+                return result;
+            }), length);
+        }
+    }
+    submit_batch();
+
+    try {
+        for (size_t i = 0; i < filenames.size(); ++i)
+        {
+            auto & plan = plans[i];
+            if (!plan.split) {
+                sink(filenames[i], plan.batch.get()[plan.batch_index]);
+                plan.batch = { }; // let go of finished batches
+                continue;
+            }
+
+            file_hash_t result;
+            if (plan.recalled) {
+                result.checksum = in_output_endian(*plan.recalled);
+                sink(filenames[i], result);
+                continue;
+            }
+
+            std::optional < CRC64 > crc64;
+            for (auto & [future, length] : plan.ranges)
+            {
+                auto range = future.get();
+                if (range.error) {
+                    if (!result.error) {
+                        result.error = range.error;
+                        result.error_number = range.error_number;
+                    }
+                } else if (!crc64) {
+                    crc64 = range.crc64;
+                } else {
+                    crc64->combine(range.crc64, length);
+                }
+            }
+
+            if (!result.error)
+            {
+                const uint64_t checksum = crc64->get_checksum(LITTLE_ENDIAN);
+                if (plan.has_key) {
+                    remember_checksum(filenames[i], plan.key, plan.started, checksum);
+                }
+                result.checksum = in_output_endian(checksum);
+            }
+
+            // from dispatching the first range to combining the last one
+            if (stats::enabled()) {
+                stats::count_file(stats::now_ns() - plan.dispatched_ns);
+            }
+            sink(filenames[i], result);
+        }
+    } catch (...) {
+        cancelled->store(true, std::memory_order_relaxed);
+        throw;
+    }
+}
+
 bool is_utf8()
 {
     if (disable_all_bullshit_codes) {
@@ -413,17 +980,6 @@ bool is_colorful()
     return false;
 }
 
-std::string remove_non_printable(const std::string& input)
-{
-    std::string output;
-    for (const char ch : input) {
-        if (std::isprint(static_cast<unsigned char>(ch))) {
-            output += ch;  // Keep only printable characters
-        }
-    }
-    return output;
-}
-
 int main(int argc, const char **argv)
 {
 #if defined(WIN32) && defined(__DEBUG__)
@@ -433,6 +989,9 @@ int main(int argc, const char **argv)
     debug::log_level = debug::WARNING;
 #endif
 
+    // results go through OutputWriter, iostreams need no stdio synchronization on top
+    std::ios::sync_with_stdio(false);
+
     try
     {
         const Arguments args(argc, argv, arguments);
@@ -455,32 +1014,255 @@ int main(int argc, const char **argv)
             }
         }
 
-        auto single_file_hash = [uppercase](const std::string & filename)->void
+        if (const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+            arg_value_ref.contains("algorithm"))
+        {
+            if (arg_value_ref.at("algorithm").size() != 1) {
+                throw std::runtime_error("Multiple definition of algorithm");
+            }
+
+            CRC64::use_algorithm(arg_value_ref.at("algorithm").at(0));
+        }
+
+        // before any pool is created, so that their threads leave SIGUSR1 to the reporter
+        std::optional < stats::Reporter > stats_reporter;
+        if (const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+            arg_value_ref.contains("stats"))
+        {
+            if (arg_value_ref.at("stats").size() != 1) {
+                throw std::runtime_error("Multiple definition of stats format");
+            }
+
+            stats_reporter.emplace(stats::format_from_name(arg_value_ref.at("stats").at(0)));
+        }
+
+        // numeric option value, 1 when the option is absent
+        auto count_argument = [&args](const std::string & name)->unsigned int
+        {
+            const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+            if (!arg_value_ref.contains(name)) {
+                return 1;
+            }
+
+            if (arg_value_ref.at(name).size() != 1) {
+                throw std::runtime_error("Multiple definition of " + name);
+            }
+
+            try {
+                return static_cast<unsigned int>(std::stoul(arg_value_ref.at(name).at(0)));
+            } catch (const std::exception &) {
+                throw std::runtime_error("Invalid value for " + name + ": " + arg_value_ref.at(name).at(0));
+            }
+        };
+
+        if (const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+            arg_value_ref.contains("io"))
+        {
+            if (arg_value_ref.at("io").size() != 1) {
+                throw std::runtime_error("Multiple definition of I/O engine");
+            }
+
+            io_options.engine = file_reader::engine_from_name(arg_value_ref.at("io").at(0));
+        }
+
+        if (const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+            arg_value_ref.contains("queue-depth"))
+        {
+            const auto depth = count_argument("queue-depth");
+            if (depth == 0) {
+                throw std::runtime_error("Queue depth must be at least 1");
+            }
+            io_options.queue_depth = depth;
+        }
+
+        if (const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+            arg_value_ref.contains("block-size"))
+        {
+            if (arg_value_ref.at("block-size").size() != 1) {
+                throw std::runtime_error("Multiple definition of block size");
+            }
+
+            const auto & value = arg_value_ref.at("block-size").at(0);
+            uint64_t block_size = 0;
+            try
+            {
+                size_t suffix = 0;
+                block_size = std::stoull(value, &suffix);
+                if (suffix + 1 == value.size()) {
+                    switch (std::toupper(static_cast<unsigned char>(value.back()))) {
+                        case 'K': block_size <<= 10; break;
+                        case 'M': block_size <<= 20; break;
+                        case 'G': block_size <<= 30; break;
+                        default: throw std::invalid_argument(value);
+                    }
+                } else if (suffix != value.size()) {
+                    throw std::invalid_argument(value);
+                }
+            } catch (const std::exception &) {
+                throw std::runtime_error("Invalid block size " + value);
+            }
+
+            if (block_size < 4096 || block_size > 1024 * 1024 * 1024) {
+                throw std::runtime_error("Block size must be between 4K and 1G");
+            }
+            io_options.block_size = block_size;
+        }
+
+        if (static_cast<Arguments::args_t>(args).contains("tee"))
+        {
+            tee_stdin = true;
+            if (const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+                arg_value_ref.contains("checksum")
+                || (arg_value_ref.contains("BARE") && std::ranges::any_of(arg_value_ref.at("BARE"),
+                    [](const std::string & filename) { return filename != "-"; })))
+            {
+                throw std::runtime_error("Tee mode only works with STDIN");
+            }
+        }
+
+        if (const auto threads = count_argument("threads"); threads != 1) {
+            range_pool = std::make_unique<ThreadPool>(threads);
+        }
+
+        if (const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+            arg_value_ref.contains("cache"))
+        {
+            if (arg_value_ref.at("cache").size() != 1) {
+                throw std::runtime_error("Multiple definition of checksum cache");
+            }
+
+            checksum_cache = std::make_unique<ChecksumCache>(arg_value_ref.at("cache").at(0), CRC64::algorithm_id());
+        }
+
+        if (const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+            arg_value_ref.contains("xattr"))
+        {
+            if (arg_value_ref.at("xattr").size() != 1) {
+                throw std::runtime_error("Multiple definition of xattr mode");
+            }
+
+            xattr_mode = checksum_xattr::mode_from_name(arg_value_ref.at("xattr").at(0));
+        }
+
+        if (static_cast<Arguments::args_t>(args).contains("force"))
+        {
+            if (!checksum_cache && xattr_mode == checksum_xattr::IGNORE) {
+                throw std::runtime_error("Forcing re-hashing needs a checksum cache or xattrs");
+            }
+            force_rehash = true;
+        }
+
+        if (const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+            arg_value_ref.contains("digest"))
+        {
+            // repeatable, and each value may list several digests separated by commas
+            for (const auto & value : arg_value_ref.at("digest"))
+            {
+                for (size_t begin = 0; begin <= value.size(); )
+                {
+                    const size_t comma = std::min(value.find(',', begin), value.size());
+                    if (const auto kind = digest::kind_from_name(value.substr(begin, comma - begin));
+                        std::ranges::find(extra_digests, kind) == extra_digests.end())
+                    {
+                        extra_digests.push_back(kind);
+                    }
+                    begin = comma + 1;
+                }
+            }
+
+            if (remembers_checksums()) {
+                throw std::runtime_error("Digests cannot be kept in a checksum cache or xattrs");
+            }
+
+            if (arg_value_ref.contains("checksum")) {
+                throw std::runtime_error("Digests are only printed when hashing files, not verified");
+            }
+        }
+
+        std::unique_ptr<ThreadPool> files_pool;
+        if (const auto jobs = count_argument("jobs"); jobs != 1) {
+            files_pool = std::make_unique<ThreadPool>(jobs);
+        }
+
+        // directories are walked with as many threads as files are hashed
+        const bool recursive = static_cast<Arguments::args_t>(args).contains("recursive");
+        directory_walker::options_t walk_options;
+        walk_options.follow_symlinks = static_cast<Arguments::args_t>(args).contains("follow-symlinks");
+        walk_options.one_file_system = static_cast<Arguments::args_t>(args).contains("one-file-system");
+        walk_options.threads = files_pool ? files_pool->size() : 1;
+
+        // in tee mode STDOUT carries the data itself
+#ifdef WIN32
+        const bool interactive = _isatty(_fileno(tee_stdin ? stderr : stdout));
+#else
+        const bool interactive = isatty(tee_stdin ? STDERR_FILENO : STDOUT_FILENO);
+#endif
+        OutputWriter output(tee_stdin ? std::cerr : std::cout,
+            interactive || static_cast<Arguments::args_t>(args).contains("line-buffered"));
+
+        auto print_file_hash = [uppercase, &output](const std::string & filename, const file_hash_t & result)->void
         {
             std::setlocale(LC_ALL, "C");
 #if defined(WIN32)
             SetConsoleOutputCP(437);
 #endif
-            const uint64_t checksum = hash_a_file(filename);
-            if (general_error) {
+            if (result.error) {
+                errno = result.error_number;
+                std::rethrow_exception(result.error);
+            }
+
+            if (result.skipped) {
                 debug::log(debug::to_stderr, debug::warning_log, "Skipped non-regular file ", filename, "\n");
-                general_error = false;
                 return;
             }
-            std::vector < char > data;
-            data.resize(sizeof(checksum));
-            (*reinterpret_cast<uint64_t *>(data.data())) = checksum;
-            std::cout << filename << ": ";
-            const auto hex = bin2hex::bin2hex(data);
+
+            // bytes in memory order, as the checksum file format expects
+            uint8_t data[sizeof(result.checksum)];
+            std::memcpy(data, &result.checksum, sizeof(data));
+            char hex[2 * sizeof(data)];
+            bin2hex::encode(data, hex);
+
+            // the other digests follow, space separated, most significant digit first
+            std::string digests;
+            for (size_t i = 0; i < result.digests.size(); ++i)
+            {
+                uint8_t value_bytes[sizeof(uint64_t)];
+                for (size_t j = 0; j < sizeof(value_bytes); ++j) {
+                    value_bytes[j] = static_cast<uint8_t>(result.digests[i] >> (56 - 8 * j));
+                }
+                char value_hex[2 * sizeof(value_bytes)];
+                bin2hex::encode(value_bytes, value_hex);
+                const size_t width = digest::hex_width(extra_digests[i]);
+                digests += ' ';
+                digests.append(value_hex + sizeof(value_hex) - width, width);
+            }
+
             if (uppercase)
             {
-                for (const char& ch : hex) {
-                    std::cout.put(static_cast<char>(std::toupper(ch)));
+                for (char & ch : hex) {
+                    ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
                 }
-            } else {
-                std::cout << hex;
+                for (char & ch : digests) {
+                    ch = static_cast<char>(std::toupper(static_cast<unsigned char>(ch)));
+                }
+            }
+            output.line(filename, ": ", std::string_view(hex, sizeof(hex)), digests);
+        };
+
+        auto single_file_hash = [&print_file_hash](const std::string & filename)->void {
+            print_file_hash(filename, hash_a_file_captured(filename));
+        };
+
+        auto report_cache = []()->void
+        {
+            if (checksum_cache) {
+                std::cerr << "Checksum cache: " << checksum_cache->hits() << " hits, "
+                          << checksum_cache->misses() << " misses";
+                if (checksum_cache->evictions() != 0) {
+                    std::cerr << ", " << checksum_cache->evictions() << " entries evicted, the cache is full";
+                }
+                std::cerr << std::endl;
             }
-            std::cout << std::endl;
         };
 
         auto print_help = [&]()->void
@@ -492,111 +1274,262 @@ int main(int argc, const char **argv)
 
 #ifdef WIN32
         _setmode(_fileno(stdin), _O_BINARY);
+        if (tee_stdin) {
+            _setmode(_fileno(stdout), _O_BINARY);
+        }
 #endif
 
+        const auto manifest_name = [&args]()->std::string {
+            const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+            if (!arg_value_ref.contains("manifest")) {
+                return "";
+            }
+            if (arg_value_ref.at("manifest").size() != 1) {
+                throw std::runtime_error("Multiple definition of manifest");
+            }
+            return arg_value_ref.at("manifest").at(0);
+        }();
+
         if (static_cast<Arguments::args_t>(args).contains("help")) {
             print_help();
             return EXIT_SUCCESS;
         }
+        else if (static_cast<Arguments::args_t>(args).contains("import"))
+        {
+            if (manifest_name.empty() || !static_cast<Arguments::args_t>(args).contains("BARE")) {
+                throw std::runtime_error("Importing needs checksum files and a --manifest to write");
+            }
+
+            // checksums in the files are read in the byte order given by --endian
+            std::vector < manifest::record_t > records;
+            for (const auto flist = static_cast<Arguments::args_t>(args).at("BARE");
+                const auto & filename : flist)
+            {
+                const manifest::TextManifest text(filename);
+                text.for_each(
+                    [&](const manifest::entry_t & entry) {
+                        if (!entry.well_formed) {
+                            debug::log(debug::to_stderr, debug::error_log,
+                                "Invalid checksum for ", std::string(entry.filename), "\n");
+                            return;
+                        }
+                        records.push_back(manifest::record_t {
+                            .filename = std::string(entry.filename),
+                            .checksum = in_output_endian(entry.checksum),
+                        });
+                    },
+                    [] {
+                        debug::log(debug::to_stderr, debug::error_log, "Invalid checksum file format\n");
+                    });
+            }
+
+            manifest::write_binary(manifest_name, std::move(records));
+            return EXIT_SUCCESS;
+        }
+        else if (static_cast<Arguments::args_t>(args).contains("export"))
+        {
+            if (!static_cast<Arguments::args_t>(args).contains("BARE")) {
+                throw std::runtime_error("Exporting needs binary manifests");
+            }
+
+            for (const auto flist = static_cast<Arguments::args_t>(args).at("BARE");
+                const auto & filename : flist)
+            {
+                const manifest::BinaryManifest binary(filename);
+                for (uint64_t i = 0; i < binary.count(); ++i)
+                {
+                    file_hash_t result;
+                    result.checksum = in_output_endian(binary.checksum(i));
+                    print_file_hash(std::string(binary.filename(i)), result);
+                }
+            }
+            output.flush();
+            return EXIT_SUCCESS;
+        }
         else if (static_cast<Arguments::args_t>(args).contains("BARE"))
         {
+            std::vector < std::string > filenames;
             for (const auto flist = static_cast<Arguments::args_t>(args).at("BARE");
                 const auto & filename : flist)
             {
-                if (filename == "-") {
-                    single_file_hash("STDIN");
+                if (std::error_code error;
+                    filename == "-")
+                {
+                    filenames.emplace_back("STDIN");
+                } else if (recursive && std::filesystem::is_directory(filename, error)) {
+                    auto files = directory_walker::list_files(filename, walk_options);
+                    filenames.insert(filenames.end(), std::make_move_iterator(files.begin()),
+                        std::make_move_iterator(files.end()));
                 } else {
-                    single_file_hash(filename);
+                    filenames.push_back(filename);
+                }
+            }
+
+            // what was hashed, with the size and modification time it was hashed at
+            std::vector < manifest::record_t > records;
+            auto sink = [&](const std::string & filename, const file_hash_t & result)->void
+            {
+                print_file_hash(filename, result);
+                if (ChecksumCache::file_key_t key { };
+                    !manifest_name.empty() && !result.skipped && filename != "STDIN"
+                    && ChecksumCache::file_key(filename, key))
+                {
+                    records.push_back(manifest::record_t {
+                        .filename = filename,
+                        .size = key.size,
+                        .mtime_ns = key.mtime_ns,
+                        .checksum = in_output_endian(result.checksum),
+                    });
                 }
+            };
+
+            // files may be hashed out of order on files_pool, results are printed in order
+            if (files_pool) {
+                hash_files_scheduled(*files_pool, filenames, sink);
+            } else {
+                for (const auto & filename : filenames) {
+                    sink(filename, hash_a_file_captured(filename));
+                }
+            }
+
+            output.flush();
+            if (!manifest_name.empty()) {
+                manifest::write_binary(manifest_name, std::move(records));
             }
+            report_cache();
             return EXIT_SUCCESS;
         }
         else if (static_cast<Arguments::args_t>(args).contains("checksum"))
         {
-            std::vector < std::string > good_files;
+            uint64_t good_count = 0;
             std::vector < std::string > bad_files;
             uint64_t file_count = 0;
 
-            for (const auto flist = static_cast<Arguments::args_t>(args).at("checksum");
-                const auto & filename : flist)
+            // result stage, runs on this thread in manifest order
+            auto verify_file = [&](const manifest::entry_t & entry, const file_hash_t & result)->void
             {
-                std::ifstream file_stream(filename, std::ios::in);
-                std::string line;
-
-                if (!file_stream) {
-                    throw std::runtime_error("Could not open file: " + filename);
-                }
-
-                while (std::getline(file_stream, line))
-                {
-                    const auto pos = line.find_last_of(':');
-                    if (pos == std::string::npos || pos == 0) {
-                        debug::log(debug::to_stderr, debug::error_log, "Invalid checksum file format\n");
-                        continue; // skip ill-formatted parts
-                    }
-
-                    const std::string fname = line.substr(0, pos);
-                    std::string checksum = line.substr(pos + 1);
-                    replace_all(checksum, " ", "");
-                    uint64_t real_checksum = 0;
+                const std::string_view fname = entry.filename;
+                if (result.error) {
                     try {
-                        file_count++; // before checksum, increase file_count
-                        real_checksum = hash_a_file(fname);
-                        if (general_error) {
-                            debug::log(debug::to_stderr, debug::warning_log, "Skipped non-regular file ", filename, "\n");
-                            general_error = false;
-                            continue;
-                        }
+                        std::rethrow_exception(result.error);
                     } catch (const std::exception & e) {
                         debug::log(debug::to_stderr, debug::error_log, e.what(), "\n");
                     }
-                    std::vector < char > data;
-                    data.resize(sizeof(real_checksum));
-                    (*reinterpret_cast<uint64_t *>(data.data())) = real_checksum;
-                    const auto real_hex = bin2hex::bin2hex(data);
-                    std::ranges::transform(checksum, checksum.begin(),
-                                           [](const unsigned char c) {
-                                               return std::tolower(c);
-                                           });
-                    checksum = remove_non_printable(checksum);
-                    if (real_hex == checksum)
-                    {
-                        good_files.emplace_back(fname);
-                        if (is_utf8()) {
-                            std::vector<unsigned char> CheckMark = {0xE2, 0x9C, 0x94, 0xEf, 0xB8, 0x8F}; /* ✔️ */
-                            std::cout.write(reinterpret_cast<const char*>(CheckMark.data()),
-                                static_cast<signed long long>(CheckMark.size()));
-                            std::cout  << "    "
-                                       << (is_colorful() ? "\033[32;1m" + fname + "\033[0m" : fname)
-                                       << std::endl;
+                } else if (result.skipped) {
+                    debug::log(debug::to_stderr, debug::warning_log, "Skipped non-regular file ", std::string(fname), "\n");
+                    return;
+                }
+
+                if (!result.error && entry.well_formed && result.checksum == entry.checksum)
+                {
+                    good_count++;
+                    if (is_utf8()) {
+                        constexpr char CheckMark[] = "\xE2\x9C\x94\xEF\xB8\x8F"; /* ✔️ */
+                        output.line(CheckMark, "    ", is_colorful() ? "\033[32;1m" : "", fname,
+                            is_colorful() ? "\033[0m" : "");
+                    } else {
+                        if (is_colorful()) {
+                            output.line("\033[32;1m" "OK  ", fname, "\033[0m");
                         } else {
-                            if (is_colorful()) {
-                                std::cout << "\033[32;1m" "OK  " + fname + "\033[0m" << std::endl;
-                            } else {
-                                std::cout << "OK  " << fname << std::endl;
-                            }
+                            output.line("OK  ", fname);
                         }
                     }
-                    else
-                    {
-                        bad_files.emplace_back(fname);
-                        if (is_utf8()) {
-                            std::vector<unsigned char> CrossMark = {0xE2, 0x9D, 0x8C}; /* ❌ */
-                            std::cout.write(reinterpret_cast<const char*>(CrossMark.data()),
-                                static_cast<signed long long>(CrossMark.size()));
-                            std::cout  << "    "
-                                       << (is_colorful() ? "\033[31;1m" + fname + "\033[0m" : fname)
-                                       << std::endl;
+                }
+                else
+                {
+                    bad_files.emplace_back(fname);
+                    if (is_utf8()) {
+                        constexpr char CrossMark[] = "\xE2\x9D\x8C"; /* ❌ */
+                        output.line(CrossMark, "    ", is_colorful() ? "\033[31;1m" : "", fname,
+                            is_colorful() ? "\033[0m" : "");
+                    } else {
+                        if (is_colorful()) {
+                            output.line("\033[31;1m" "BAD ", fname, "\033[0m");
                         } else {
-                            if (is_colorful()) {
-                                std::cout << "\033[31;1m" "BAD " + fname + "\033[0m" << std::endl;
-                            } else {
-                                std::cout << "BAD " << fname << std::endl;
-                            }
+                            output.line("BAD ", fname);
+                        }
+                    }
+                }
+            };
+
+            // hashing stage, on files_pool when -j is given
+            OrderedPipeline < manifest::entry_t, file_hash_t > pipeline(files_pool.get(),
+                [](const manifest::entry_t & entry) { return hash_a_file_captured(std::string(entry.filename)); },
+                verify_file);
+
+            // --only paths, a trailing / selects everything below a directory
+            std::vector < std::string > only;
+            if (const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+                arg_value_ref.contains("only"))
+            {
+                only = arg_value_ref.at("only");
+            }
+
+            auto selected = [&only](const std::string_view filename) {
+                return only.empty() || std::ranges::any_of(only, [filename](const std::string & path) {
+                    return path.ends_with('/') ? filename.starts_with(path) : filename == path;
+                });
+            };
+
+            auto verify_entry = [&](const manifest::entry_t & entry) {
+                file_count++; // before checksum, increase file_count
+                pipeline.push(entry);
+            };
+
+            // parser stage, entries point into the manifests, which are kept until everything is verified
+            std::vector < std::unique_ptr < manifest::TextManifest > > text_manifests;
+            std::vector < std::unique_ptr < manifest::BinaryManifest > > binary_manifests;
+            for (const auto flist = static_cast<Arguments::args_t>(args).at("checksum");
+                const auto & filename : flist)
+            {
+                if (manifest::is_binary(filename))
+                {
+                    // sorted, --only paths are looked up instead of scanning every record
+                    const auto & binary = *binary_manifests.emplace_back(
+                        std::make_unique<manifest::BinaryManifest>(filename));
+                    auto verify_records = [&](const uint64_t first, const uint64_t last) {
+                        for (uint64_t i = first; i < last; ++i) {
+                            verify_entry(manifest::entry_t {
+                                .filename = binary.filename(i),
+                                .checksum = in_output_endian(binary.checksum(i)),
+                                .well_formed = true,
+                            });
                         }
+                    };
+
+                    if (only.empty()) {
+                        verify_records(0, binary.count());
+                        continue;
+                    }
+
+                    // overlapping paths, e.g., a/ and a/b/, select some records twice, merge them first
+                    std::vector < std::pair < uint64_t, uint64_t > > ranges;
+                    for (const auto & path : only) {
+                        ranges.push_back(binary.select(path));
+                    }
+                    std::ranges::sort(ranges);
+                    uint64_t verified = 0;
+                    for (const auto & [first, last] : ranges) {
+                        verify_records(std::max(first, verified), last);
+                        verified = std::max(verified, last);
                     }
+                    continue;
                 }
+
+                text_manifests.emplace_back(std::make_unique<manifest::TextManifest>(filename));
+                text_manifests.back()->for_each(
+                    [&](const manifest::entry_t & entry) {
+                        if (selected(entry.filename)) {
+                            verify_entry(entry);
+                        }
+                    },
+                    [] {
+                        debug::log(debug::to_stderr, debug::error_log, "Invalid checksum file format\n");
+                    });
             }
+            pipeline.finish();
+            output.flush();
+            report_cache();
 
             if (!bad_files.empty())
             {
@@ -614,12 +1547,12 @@ int main(int argc, const char **argv)
 
             std::cout << "Checksum completed (Good/Bad/All) ("
                       << (is_colorful() ? "\033[32;1m" : "")
-                      << good_files.size() << (is_colorful() ? "\033[0m" : "") << "/"
+                      << good_count << (is_colorful() ? "\033[0m" : "") << "/"
                       << (is_colorful() ? (bad_files.empty() ? "\033[32;1m" : "\033[31;1m") : "")
                       << bad_files.size() << (is_colorful() ? "\033[0m" : "") << "/"
                       << (is_colorful() ? "\033[34;1m" : "") << file_count << (is_colorful() ? "\033[0m" : "")
                       << ")" << std::endl;
-            if (good_files.size() == file_count && bad_files.empty())
+            if (good_count == file_count && bad_files.empty())
             {
                 std::cout << (is_colorful() ? "\033[32;1m" : "")
                           << "File integrity ensured"
@@ -0,0 +1,390 @@
+/* checksum_cache.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "checksum_cache.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __unix__
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <sys/file.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif // __unix__
+
+namespace {
+    constexpr char cache_magic[8] = { 'C', 'R', 'C', '6', '4', 'C', 'H', 'E' };
+    constexpr uint32_t cache_version = 1;
+    constexpr uint64_t initial_slot_count = 1 << 18;    // 16 MiB of slots, only the touched pages take up disk space
+    constexpr uint64_t max_slot_count = 1 << 24;        // 1 GiB, past that a full probe window evicts its home slot
+    constexpr uint64_t probe_length = 8;                // slots searched from the home slot
+    constexpr size_t header_size = 4096;
+
+    struct header_t {
+        char magic[8];
+        uint32_t version;
+        uint32_t slot_size;
+        uint64_t slot_count;
+    };
+
+    // splitmix64 finalizer, inode numbers are far from uniformly distributed
+    uint64_t mix(uint64_t x)
+    {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBULL;
+        x ^= x >> 31;
+        return x;
+    }
+
+    // where the probe window of a file starts, before masking with the slot count
+    uint64_t home_of(const ChecksumCache::file_key_t & key)
+    {
+        return mix(key.device * 0x9E3779B97F4A7C15ULL ^ key.inode);
+    }
+
+    uint64_t load(uint64_t & word, const std::memory_order order = std::memory_order_relaxed) {
+        return std::atomic_ref(word).load(order);
+    }
+
+    void save(uint64_t & word, const uint64_t value, const std::memory_order order = std::memory_order_relaxed) {
+        std::atomic_ref(word).store(value, order);
+    }
+}
+
+// one cache line per entry, sequence is odd while the entry is being written and 0 while it is empty
+struct alignas(64) ChecksumCache::slot_t {
+    uint64_t sequence;
+    uint64_t device;
+    uint64_t inode;
+    uint64_t size;
+    uint64_t mtime_ns;
+    uint64_t checksum;
+    uint64_t algorithm; // CRC64::algorithm_id(), 0 in caches written before there was a choice
+    uint64_t reserved;
+};
+
+#ifdef __unix__
+// holds an flock(2) lock for the lifetime of the scope
+class file_lock_t {
+    int fd;
+public:
+    file_lock_t(const int fd_, const int operation) : fd(fd_)
+    {
+        while (flock(fd, operation) != 0) {
+            if (errno != EINTR) {
+                throw std::runtime_error("Cannot lock checksum cache");
+            }
+        }
+    }
+
+    ~file_lock_t() { flock(fd, LOCK_UN); }
+
+    file_lock_t(const file_lock_t &) = delete;
+    file_lock_t & operator=(const file_lock_t &) = delete;
+};
+
+ChecksumCache::ChecksumCache(const std::string & path_, const uint64_t algorithm_)
+    : path(path_), algorithm(algorithm_)
+{
+    use_table(open_table());
+}
+
+ChecksumCache::~ChecksumCache()
+{
+    for (const auto & mapped : tables)
+    {
+        munmap(mapped->map, mapped->map_size);
+        close(mapped->fd);
+    }
+}
+
+std::unique_ptr < ChecksumCache::table_t > ChecksumCache::open_table() const
+{
+    auto next = std::make_unique < table_t >();
+    next->fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (next->fd < 0) {
+        throw std::runtime_error("Cannot open checksum cache " + path);
+    }
+
+    try
+    {
+        // whoever comes first lays the table out, everyone else only checks it
+        const file_lock_t lock(next->fd, LOCK_EX);
+        struct stat info { };
+        if (fstat(next->fd, &info) != 0) {
+            throw std::runtime_error("Cannot stat checksum cache " + path);
+        }
+
+        header_t header { };
+        if (info.st_size == 0)
+        {
+            std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+            header.version = cache_version;
+            header.slot_size = sizeof(slot_t);
+            header.slot_count = initial_slot_count;
+            if (ftruncate(next->fd, static_cast<off_t>(header_size + initial_slot_count * sizeof(slot_t))) != 0
+                || pwrite(next->fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)))
+            {
+                throw std::runtime_error("Cannot initialize checksum cache " + path);
+            }
+        }
+        else if (pread(next->fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))
+            || std::memcmp(header.magic, cache_magic, sizeof(cache_magic)) != 0
+            || header.version != cache_version
+            || header.slot_size != sizeof(slot_t)
+            || header.slot_count < initial_slot_count
+            || header.slot_count > max_slot_count
+            || (header.slot_count & (header.slot_count - 1)) != 0
+            || static_cast<uint64_t>(info.st_size) != header_size + header.slot_count * sizeof(slot_t))
+        {
+            errno = EINVAL;
+            throw std::runtime_error("Not a checksum cache: " + path);
+        }
+
+        next->slot_count = header.slot_count;
+        next->map_size = header_size + next->slot_count * sizeof(slot_t);
+        next->map = mmap(nullptr, next->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, next->fd, 0);
+        if (next->map == MAP_FAILED) {
+            throw std::runtime_error("Cannot map checksum cache " + path);
+        }
+    } catch (...) {
+        close(next->fd);
+        throw;
+    }
+
+    next->slots = reinterpret_cast<slot_t *>(static_cast<uint8_t *>(next->map) + header_size);
+    return next;
+}
+
+// full copied into a table twice its size, which is renamed over the cache file; nullptr if that cannot be done.
+// The caller holds the lock on full, so no entry changes meanwhile.
+std::unique_ptr < ChecksumCache::table_t > ChecksumCache::grow(const table_t & full) const
+{
+    if (full.slot_count >= max_slot_count) {
+        return nullptr;
+    }
+
+    const std::string temporary = path + ".grow." + std::to_string(getpid());
+    auto next = std::make_unique < table_t >();
+    next->slot_count = full.slot_count * 2;
+    next->map_size = header_size + next->slot_count * sizeof(slot_t);
+    next->fd = open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (next->fd < 0) {
+        return nullptr;
+    }
+
+    header_t header { };
+    std::memcpy(header.magic, cache_magic, sizeof(cache_magic));
+    header.version = cache_version;
+    header.slot_size = sizeof(slot_t);
+    header.slot_count = next->slot_count;
+    struct stat info { };
+    if (fstat(full.fd, &info) != 0
+        || fchmod(next->fd, info.st_mode & 07777) != 0
+        || ftruncate(next->fd, static_cast<off_t>(next->map_size)) != 0
+        || pwrite(next->fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))
+        || (next->map = mmap(nullptr, next->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, next->fd, 0)) == MAP_FAILED)
+    {
+        close(next->fd);
+        unlink(temporary.c_str());
+        return nullptr;
+    }
+
+    // nobody else sees the copy before it is renamed, entries left torn by a crashed writer stay behind
+    next->slots = reinterpret_cast<slot_t *>(static_cast<uint8_t *>(next->map) + header_size);
+    for (uint64_t i = 0; i < full.slot_count; ++i)
+    {
+        const slot_t & slot = full.slots[i];
+        if (slot.sequence == 0 || (slot.sequence & 1) != 0) {
+            continue;
+        }
+
+        const file_key_t key { .device = slot.device, .inode = slot.inode, .size = slot.size,
+            .mtime_ns = static_cast<int64_t>(slot.mtime_ns) };
+        if (slot_t * target = find_slot(*next, key, slot.algorithm); target && target->sequence == 0) {
+            *target = slot;
+            target->sequence = 2;
+        }
+    }
+
+    if (rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        munmap(next->map, next->map_size);
+        close(next->fd);
+        unlink(temporary.c_str());
+        return nullptr;
+    }
+
+    return next;
+}
+
+bool ChecksumCache::file_key(const std::string & filename, file_key_t & key)
+{
+    struct stat info { };
+    if (stat(filename.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) {
+        return false;
+    }
+
+    key.device = info.st_dev;
+    key.inode = info.st_ino;
+    key.size = info.st_size;
+    key.mtime_ns = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    return true;
+}
+#else
+ChecksumCache::ChecksumCache(const std::string & path_, const uint64_t algorithm_)
+    : path(path_), algorithm(algorithm_)
+{
+    use_table(open_table());
+}
+
+ChecksumCache::~ChecksumCache() = default;
+
+std::unique_ptr < ChecksumCache::table_t > ChecksumCache::open_table() const
+{
+    throw std::runtime_error("Checksum cache is not supported on this platform");
+}
+
+std::unique_ptr < ChecksumCache::table_t > ChecksumCache::grow(const table_t &) const
+{
+    return nullptr;
+}
+
+bool ChecksumCache::file_key(const std::string &, file_key_t &)
+{
+    return false;
+}
+#endif // __unix__
+
+void ChecksumCache::use_table(std::unique_ptr < table_t > next)
+{
+    tables.push_back(std::move(next));
+    table.store(tables.back().get(), std::memory_order_release);
+}
+
+// the slot of this file and variant, else the first empty one, nullptr if the probe window is full
+ChecksumCache::slot_t * ChecksumCache::find_slot(const table_t & table, const file_key_t & key, const uint64_t algorithm)
+{
+    const uint64_t home = home_of(key);
+    for (uint64_t i = 0; i < probe_length; ++i)
+    {
+        slot_t & slot = table.slots[(home + i) & (table.slot_count - 1)];
+        if (load(slot.sequence) == 0
+            || (load(slot.device) == key.device && load(slot.inode) == key.inode && load(slot.algorithm) == algorithm))
+        {
+            return &slot;
+        }
+    }
+
+    return nullptr;
+}
+
+bool ChecksumCache::lookup(const file_key_t & key, uint64_t & checksum)
+{
+    const table_t & current = *table.load(std::memory_order_acquire);
+    const uint64_t home = home_of(key);
+    for (uint64_t i = 0; i < probe_length; ++i)
+    {
+        slot_t & slot = current.slots[(home + i) & (current.slot_count - 1)];
+        const uint64_t sequence = load(slot.sequence, std::memory_order_acquire);
+        if (sequence == 0) {
+            break; // entries are never removed, nothing for this file past an empty slot
+        }
+
+        const file_key_t entry {
+            .device = load(slot.device),
+            .inode = load(slot.inode),
+            .size = load(slot.size),
+            .mtime_ns = static_cast<int64_t>(load(slot.mtime_ns)),
+        };
+        const uint64_t value = load(slot.checksum);
+        const uint64_t value_algorithm = load(slot.algorithm);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((sequence & 1) != 0 || load(slot.sequence) != sequence) {
+            continue; // torn by a concurrent store
+        }
+
+        if (entry.device == key.device && entry.inode == key.inode && value_algorithm == algorithm)
+        {
+            if (entry == key) {
+                checksum = value;
+                ++hit_count;
+                return true;
+            }
+            break; // same file, changed since
+        }
+    }
+
+    ++miss_count;
+    return false;
+}
+
+#ifdef __unix__
+void ChecksumCache::store(const file_key_t & key, const uint64_t checksum)
+{
+    const std::lock_guard<std::mutex> thread_lock(store_mutex);
+    while (true)
+    {
+        // locks are taken on older tables before newer ones, by every process
+        table_t & current = *table.load(std::memory_order_relaxed);
+        const file_lock_t lock(current.fd, LOCK_EX);
+
+        // another process grew the table and renamed its copy over this one, move over to it
+        if (struct stat info { }; fstat(current.fd, &info) == 0 && info.st_nlink == 0) {
+            use_table(open_table());
+            continue;
+        }
+
+        slot_t * target = find_slot(current, key, algorithm);
+        if (!target)
+        {
+            if (auto next = grow(current)) {
+                use_table(std::move(next));
+                continue;
+            }
+
+            target = current.slots + (home_of(key) & (current.slot_count - 1));
+            ++eviction_count;
+        }
+
+        // odd while writing, a crashed writer leaves it odd and the entry is skipped until rewritten
+        const uint64_t writing = load(target->sequence) | 1;
+        save(target->sequence, writing);
+        std::atomic_thread_fence(std::memory_order_release);
+        save(target->device, key.device);
+        save(target->inode, key.inode);
+        save(target->size, key.size);
+        save(target->mtime_ns, static_cast<uint64_t>(key.mtime_ns));
+        save(target->checksum, checksum);
+        save(target->algorithm, algorithm);
+        save(target->sequence, writing + 1, std::memory_order_release);
+        return;
+    }
+}
+#else
+void ChecksumCache::store(const file_key_t &, uint64_t)
+{
+}
+#endif // __unix__
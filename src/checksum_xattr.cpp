@@ -0,0 +1,119 @@
+/* checksum_xattr.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "checksum_xattr.h"
+#include "crc64.h"
+#include <charconv>
+#include <cstdio>
+#include <stdexcept>
+
+#ifdef __linux__
+# include <sys/types.h>
+# include <sys/xattr.h>
+#endif // __linux__
+
+namespace checksum_xattr {
+    namespace {
+        // user.crc64 for CRC-64/XZ, user.crc64.<algorithm> for the other variants
+        std::string attribute_name()
+        {
+            return CRC64::algorithm_id() == 0 ? "user.crc64" : std::string("user.crc64.") + CRC64::algorithm_name();
+        }
+
+        // "<checksum> <size> <mtime_ns>", the checksum in hex reads the same as the default output
+        template < typename Type >
+        bool parse_field(const char *& begin, const char * end, Type & value, const int base = 10)
+        {
+            const auto [ptr, error] = std::from_chars(begin, end, value, base);
+            if (error != std::errc() || (ptr != end && *ptr != ' ')) {
+                return false;
+            }
+
+            begin = ptr == end ? ptr : ptr + 1;
+            return true;
+        }
+    }
+
+    mode_t mode_from_name(const std::string & name)
+    {
+        if (name == "ignore") {
+            return IGNORE;
+        }
+        if (name == "trust") {
+            return TRUST;
+        }
+        if (name == "populate") {
+            return POPULATE;
+        }
+
+        throw std::runtime_error("Unknown xattr mode " + name);
+    }
+
+#ifdef __linux__
+    bool load(const std::string & filename, const ChecksumCache::file_key_t & key, uint64_t & checksum)
+    {
+        char value[64] { };
+        const auto length = getxattr(filename.c_str(), attribute_name().c_str(), value, sizeof(value));
+        if (length <= 0) {
+            return false;
+        }
+
+        const char * begin = value;
+        const char * end = value + length;
+        uint64_t size = 0;
+        int64_t mtime_ns = 0;
+        uint64_t stored = 0;
+        if (!parse_field(begin, end, stored, 16)
+            || !parse_field(begin, end, size)
+            || !parse_field(begin, end, mtime_ns)
+            || begin != end)
+        {
+            return false;
+        }
+
+        if (size != key.size || mtime_ns != key.mtime_ns) {
+            return false;
+        }
+
+        checksum = stored;
+        return true;
+    }
+
+    bool store(const std::string & filename, const ChecksumCache::file_key_t & key, const uint64_t checksum)
+    {
+        char value[64] { };
+        const int length = std::snprintf(value, sizeof(value), "%016llx %llu %lld",
+            static_cast<unsigned long long>(checksum),
+            static_cast<unsigned long long>(key.size),
+            static_cast<long long>(key.mtime_ns));
+        return setxattr(filename.c_str(), attribute_name().c_str(), value, length, 0) == 0;
+    }
+#else
+    bool load(const std::string &, const ChecksumCache::file_key_t &, uint64_t &)
+    {
+        return false;
+    }
+
+    bool store(const std::string &, const ChecksumCache::file_key_t &, uint64_t)
+    {
+        return false; // no extended attributes on this platform
+    }
+#endif // __linux__
+}
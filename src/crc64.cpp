@@ -0,0 +1,555 @@
+/* crc64.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <array>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+# define CRC64_X86_64
+# include <immintrin.h>
+# ifdef _MSC_VER
+#  include <intrin.h>
+# else
+#  include <cpuid.h>
+# endif // _MSC_VER
+#endif // __x86_64__ || _M_X64
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+# define CRC64_AARCH64
+# include <arm_neon.h>
+# if defined(__linux__)
+#  include <sys/auxv.h>
+#  include <asm/hwcap.h>
+# elif defined(WIN32)
+#  include <windows.h>
+# endif
+#endif // __aarch64__ || _M_ARM64
+
+#include "crc64.h"
+#include "crc64_engine.h"
+
+#if defined(__clang__) || defined(__GNUC__)
+# define CRC64_TARGET(features) __attribute__((target(features)))
+#else
+# define CRC64_TARGET(features)
+#endif
+
+std::string getEnvVar(const std::string &);
+
+namespace {
+    using slice_table_t = std::array < std::array < uint64_t, 256 >, 16 >;
+
+    // table[k] advances the classic byte-wise table[0] by k more zero bytes, so that 16 independent
+    // lookups can be folded together in one iteration; the first 8 are those of the generic engine
+    constexpr slice_table_t make_slice_tables()
+    {
+        slice_table_t result {};
+        for (size_t k = 0; k < crc64_xz_t::tables.size(); ++k) {
+            result[k] = crc64_xz_t::tables[k];
+        }
+
+        for (uint64_t i = 0; i < 256; ++i) {
+            for (size_t k = crc64_xz_t::tables.size(); k < result.size(); ++k) {
+                const uint64_t prev = result[k - 1][i];
+                result[k][i] = result[0][prev & 0xFF] ^ (prev >> 8);
+            }
+        }
+
+        return result;
+    }
+
+    constexpr slice_table_t slice_table = make_slice_tables();
+
+    uint64_t load_le64(const uint8_t * data)
+    {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        if constexpr (std::endian::native == std::endian::big) {
+            word = CRC64::reverse_bytes(word);
+        }
+        return word;
+    }
+
+    uint64_t crc64_table(uint64_t crc, const uint8_t * data, size_t length)
+    {
+        const auto & table = slice_table;
+
+        // scalar head, until data is 8-byte aligned
+        while (length != 0 && (reinterpret_cast<uintptr_t>(data) & 0x07) != 0) {
+            crc = table[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+            --length;
+        }
+
+        // slice-by-16, two 64-bit words per iteration
+        while (length >= 16)
+        {
+            const uint64_t low = load_le64(data) ^ crc;
+            const uint64_t high = load_le64(data + 8);
+            crc = table[15][low & 0xFF]         ^ table[14][(low >> 8) & 0xFF]
+                ^ table[13][(low >> 16) & 0xFF] ^ table[12][(low >> 24) & 0xFF]
+                ^ table[11][(low >> 32) & 0xFF] ^ table[10][(low >> 40) & 0xFF]
+                ^ table[9][(low >> 48) & 0xFF]  ^ table[8][low >> 56]
+                ^ table[7][high & 0xFF]         ^ table[6][(high >> 8) & 0xFF]
+                ^ table[5][(high >> 16) & 0xFF] ^ table[4][(high >> 24) & 0xFF]
+                ^ table[3][(high >> 32) & 0xFF] ^ table[2][(high >> 40) & 0xFF]
+                ^ table[1][(high >> 48) & 0xFF] ^ table[0][high >> 56];
+            data += 16;
+            length -= 16;
+        }
+
+        // slice-by-8 for the last full word
+        if (length >= 8)
+        {
+            const uint64_t word = load_le64(data) ^ crc;
+            crc = table[7][word & 0xFF]         ^ table[6][(word >> 8) & 0xFF]
+                ^ table[5][(word >> 16) & 0xFF] ^ table[4][(word >> 24) & 0xFF]
+                ^ table[3][(word >> 32) & 0xFF] ^ table[2][(word >> 40) & 0xFF]
+                ^ table[1][(word >> 48) & 0xFF] ^ table[0][word >> 56];
+            data += 8;
+            length -= 8;
+        }
+
+        // scalar tail
+        while (length--) {
+            crc = table[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+        }
+
+        return crc;
+    }
+
+    /*
+     * Folding constants for the carry-less multiply kernels.
+     * A 128-bit lane holding the (bit-reflected) polynomial L * x^64 + H is moved D bits forward by
+     * L * (x^(D+63) mod P) + H * (x^(D-1) mod P), the extra x^-1 compensates for the one-bit shift
+     * a reflected carry-less product carries. Each pair below is { lo: x^(D+63), hi: x^(D-1) }, bit-reflected.
+     */
+    struct fold_constant_t {
+        uint64_t lo;
+        uint64_t hi;
+    };
+
+    constexpr fold_constant_t fold_128  { 0xe05dd497ca393ae4, 0xdabe95afc7875f40 };
+    constexpr fold_constant_t fold_256  { 0x60095b008a9efa44, 0x3be653a30fe1af51 };
+    constexpr fold_constant_t fold_384  { 0xb5ea1af9c013aca4, 0x69a35d91c3730254 };
+    constexpr fold_constant_t fold_512  { 0x6ae3efbb9dd441f3, 0x081f6054a7842df4 };
+    constexpr fold_constant_t fold_640  { 0x2e30203212cac325, 0x0e31d519421a63a5 };
+    constexpr fold_constant_t fold_768  { 0x2fe3fd2920ce82ec, 0xe4ce2cd55fea0037 };
+    constexpr fold_constant_t fold_896  { 0x9e735cb59b4724da, 0x947874de595052cb };
+    constexpr fold_constant_t fold_1024 { 0x8757d71d4fcc1000, 0xd7d86b2af73de740 };
+    constexpr fold_constant_t fold_1536 { 0x47b00921f036ff71, 0xb0382771eb06c453 };
+    constexpr fold_constant_t fold_2048 { 0x8260adf2381ad81c, 0xf31fd9271e228b79 };
+
+    // the folded 128-bit remainder is a 16-byte message whose CRC, starting from zero,
+    // equals the register value, so the table kernel does the final reduction
+    uint64_t reduce_128(const uint8_t remainder[16])
+    {
+        return crc64_table(0, remainder, 16);
+    }
+
+    // below these sizes folding does not pay for its setup
+    constexpr size_t fold_threshold = 256;
+    constexpr size_t wide_fold_threshold = 1024;
+
+#ifdef CRC64_X86_64
+    CRC64_TARGET("pclmul,sse2")
+    inline __m128i fold(const __m128i lane, const __m128i constant)
+    {
+        return _mm_xor_si128(_mm_clmulepi64_si128(lane, constant, 0x00),
+                             _mm_clmulepi64_si128(lane, constant, 0x11));
+    }
+
+    CRC64_TARGET("pclmul,sse2")
+    inline __m128i load_constant(const fold_constant_t & constant)
+    {
+        return _mm_set_epi64x(static_cast<long long>(constant.hi), static_cast<long long>(constant.lo));
+    }
+
+    CRC64_TARGET("pclmul,sse2")
+    uint64_t crc64_pclmul(uint64_t crc, const uint8_t * data, size_t length)
+    {
+        if (length < fold_threshold) {
+            return crc64_table(crc, data, length);
+        }
+
+        auto load = [](const uint8_t * ptr)->__m128i {
+            return _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+        };
+
+        // eight accumulators, 128 bytes per iteration
+        __m128i lanes[8];
+        for (int i = 0; i < 8; ++i) {
+            lanes[i] = load(data + i * 16);
+        }
+        lanes[0] = _mm_xor_si128(lanes[0], _mm_cvtsi64_si128(static_cast<long long>(crc)));
+        data += 128;
+        length -= 128;
+
+        const __m128i k1024 = load_constant(fold_1024);
+        while (length >= 128)
+        {
+            for (int i = 0; i < 8; ++i) {
+                lanes[i] = _mm_xor_si128(fold(lanes[i], k1024), load(data + i * 16));
+            }
+            data += 128;
+            length -= 128;
+        }
+
+        // merge all accumulators into the last one
+        __m128i acc = lanes[7];
+        acc = _mm_xor_si128(acc, fold(lanes[0], load_constant(fold_896)));
+        acc = _mm_xor_si128(acc, fold(lanes[1], load_constant(fold_768)));
+        acc = _mm_xor_si128(acc, fold(lanes[2], load_constant(fold_640)));
+        acc = _mm_xor_si128(acc, fold(lanes[3], load_constant(fold_512)));
+        acc = _mm_xor_si128(acc, fold(lanes[4], load_constant(fold_384)));
+        acc = _mm_xor_si128(acc, fold(lanes[5], load_constant(fold_256)));
+        acc = _mm_xor_si128(acc, fold(lanes[6], load_constant(fold_128)));
+
+        const __m128i k128 = load_constant(fold_128);
+        while (length >= 16)
+        {
+            acc = _mm_xor_si128(fold(acc, k128), load(data));
+            data += 16;
+            length -= 16;
+        }
+
+        alignas(16) uint8_t remainder[16];
+        _mm_store_si128(reinterpret_cast<__m128i *>(remainder), acc);
+        return crc64_table(reduce_128(remainder), data, length);
+    }
+
+    CRC64_TARGET("pclmul,vpclmulqdq,avx512f")
+    inline __m512i fold(const __m512i lanes, const __m512i constant)
+    {
+        return _mm512_xor_si512(_mm512_clmulepi64_epi128(lanes, constant, 0x00),
+                                _mm512_clmulepi64_epi128(lanes, constant, 0x11));
+    }
+
+    CRC64_TARGET("pclmul,vpclmulqdq,avx512f")
+    inline __m512i load_constant_x4(const fold_constant_t & constant)
+    {
+        return _mm512_broadcast_i32x4(
+            _mm_set_epi64x(static_cast<long long>(constant.hi), static_cast<long long>(constant.lo)));
+    }
+
+    CRC64_TARGET("pclmul,vpclmulqdq,avx512f")
+    uint64_t crc64_vpclmul(uint64_t crc, const uint8_t * data, size_t length)
+    {
+        if (length < wide_fold_threshold) {
+            return crc64_pclmul(crc, data, length);
+        }
+
+        // four ZMM accumulators of four 128-bit lanes each, 256 bytes per iteration
+        __m512i lanes[4];
+        for (int i = 0; i < 4; ++i) {
+            lanes[i] = _mm512_loadu_si512(data + i * 64);
+        }
+        lanes[0] = _mm512_xor_si512(lanes[0],
+            _mm512_castsi128_si512(_mm_cvtsi64_si128(static_cast<long long>(crc))));
+        data += 256;
+        length -= 256;
+
+        const __m512i k2048 = load_constant_x4(fold_2048);
+        while (length >= 256)
+        {
+            for (int i = 0; i < 4; ++i) {
+                lanes[i] = _mm512_xor_si512(fold(lanes[i], k2048), _mm512_loadu_si512(data + i * 64));
+            }
+            data += 256;
+            length -= 256;
+        }
+
+        // merge the accumulators into the last one, then its four lanes into one
+        __m512i wide = lanes[3];
+        wide = _mm512_ternarylogic_epi64(wide, fold(lanes[0], load_constant_x4(fold_1536)),
+                                         fold(lanes[1], load_constant_x4(fold_1024)), 0x96);
+        wide = _mm512_xor_si512(wide, fold(lanes[2], load_constant_x4(fold_512)));
+
+        __m128i acc = _mm512_extracti32x4_epi32(wide, 3);
+        acc = _mm_xor_si128(acc, fold(_mm512_extracti32x4_epi32(wide, 0), load_constant(fold_384)));
+        acc = _mm_xor_si128(acc, fold(_mm512_extracti32x4_epi32(wide, 1), load_constant(fold_256)));
+        acc = _mm_xor_si128(acc, fold(_mm512_extracti32x4_epi32(wide, 2), load_constant(fold_128)));
+
+        const __m128i k128 = load_constant(fold_128);
+        while (length >= 16)
+        {
+            acc = _mm_xor_si128(fold(acc, k128),
+                                _mm_loadu_si128(reinterpret_cast<const __m128i *>(data)));
+            data += 16;
+            length -= 16;
+        }
+
+        alignas(16) uint8_t remainder[16];
+        _mm_store_si128(reinterpret_cast<__m128i *>(remainder), acc);
+        return crc64_table(reduce_128(remainder), data, length);
+    }
+
+    void cpuid(const unsigned int leaf, const unsigned int subleaf, unsigned int regs[4])
+    {
+#ifdef _MSC_VER
+        int info[4] {};
+        __cpuidex(info, static_cast<int>(leaf), static_cast<int>(subleaf));
+        for (int i = 0; i < 4; ++i) {
+            regs[i] = static_cast<unsigned int>(info[i]);
+        }
+#else
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+        if (leaf > __get_cpuid_max(0, nullptr)) {
+            return;
+        }
+        __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif // _MSC_VER
+    }
+
+    bool cpu_has_pclmul()
+    {
+        unsigned int regs[4];
+        cpuid(1, 0, regs);
+        return (regs[2] & (1u << 1)) != 0;
+    }
+
+    bool cpu_has_vpclmul_avx512()
+    {
+        unsigned int regs[4];
+        cpuid(1, 0, regs);
+        if ((regs[2] & (1u << 27)) == 0) { // OSXSAVE
+            return false;
+        }
+
+        // the OS has to preserve the opmask and all ZMM registers, i.e., XCR0 bits 1, 2, 5, 6 and 7
+#ifdef _MSC_VER
+        const uint64_t xcr0 = _xgetbv(0);
+#else
+        uint32_t xcr0_lo = 0, xcr0_hi = 0;
+        __asm__ volatile ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+        const uint64_t xcr0 = (static_cast<uint64_t>(xcr0_hi) << 32) | xcr0_lo;
+#endif // _MSC_VER
+        if ((xcr0 & 0xE6) != 0xE6) {
+            return false;
+        }
+
+        cpuid(7, 0, regs);
+        const bool avx512f = (regs[1] & (1u << 16)) != 0;
+        const bool vpclmulqdq = (regs[2] & (1u << 10)) != 0;
+        return avx512f && vpclmulqdq && cpu_has_pclmul();
+    }
+#endif // CRC64_X86_64
+
+#ifdef CRC64_AARCH64
+# if defined(__clang__)
+#  define CRC64_PMULL_TARGET CRC64_TARGET("aes")
+# else
+#  define CRC64_PMULL_TARGET CRC64_TARGET("+crypto")
+# endif
+
+    CRC64_PMULL_TARGET
+    inline uint64x2_t fold(const uint64x2_t lane, const fold_constant_t & constant)
+    {
+        const poly128_t lo = vmull_p64(static_cast<poly64_t>(vgetq_lane_u64(lane, 0)),
+                                       static_cast<poly64_t>(constant.lo));
+        const poly128_t hi = vmull_p64(static_cast<poly64_t>(vgetq_lane_u64(lane, 1)),
+                                       static_cast<poly64_t>(constant.hi));
+        return veorq_u64(vreinterpretq_u64_p128(lo), vreinterpretq_u64_p128(hi));
+    }
+
+    CRC64_PMULL_TARGET
+    uint64_t crc64_pmull(uint64_t crc, const uint8_t * data, size_t length)
+    {
+        if (length < fold_threshold) {
+            return crc64_table(crc, data, length);
+        }
+
+        auto load = [](const uint8_t * ptr)->uint64x2_t {
+            return vreinterpretq_u64_u8(vld1q_u8(ptr));
+        };
+
+        // eight accumulators, 128 bytes per iteration
+        uint64x2_t lanes[8];
+        for (int i = 0; i < 8; ++i) {
+            lanes[i] = load(data + i * 16);
+        }
+        lanes[0] = veorq_u64(lanes[0], vcombine_u64(vcreate_u64(crc), vcreate_u64(0)));
+        data += 128;
+        length -= 128;
+
+        while (length >= 128)
+        {
+            for (int i = 0; i < 8; ++i) {
+                lanes[i] = veorq_u64(fold(lanes[i], fold_1024), load(data + i * 16));
+            }
+            data += 128;
+            length -= 128;
+        }
+
+        // merge all accumulators into the last one
+        uint64x2_t acc = lanes[7];
+        acc = veorq_u64(acc, fold(lanes[0], fold_896));
+        acc = veorq_u64(acc, fold(lanes[1], fold_768));
+        acc = veorq_u64(acc, fold(lanes[2], fold_640));
+        acc = veorq_u64(acc, fold(lanes[3], fold_512));
+        acc = veorq_u64(acc, fold(lanes[4], fold_384));
+        acc = veorq_u64(acc, fold(lanes[5], fold_256));
+        acc = veorq_u64(acc, fold(lanes[6], fold_128));
+
+        while (length >= 16)
+        {
+            acc = veorq_u64(fold(acc, fold_128), load(data));
+            data += 16;
+            length -= 16;
+        }
+
+        alignas(16) uint8_t remainder[16];
+        vst1q_u8(remainder, vreinterpretq_u8_u64(acc));
+        return crc64_table(reduce_128(remainder), data, length);
+    }
+
+    bool cpu_has_pmull()
+    {
+# if defined(__linux__)
+        return (getauxval(AT_HWCAP) & HWCAP_PMULL) != 0;
+# elif defined(__APPLE__)
+        return true; // every Apple silicon core has the crypto extension
+# elif defined(WIN32)
+        return IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE) != 0;
+# else
+        return false;
+# endif
+    }
+#endif // CRC64_AARCH64
+
+    using kernel_entry_t = CRC64::kernel_entry_t;
+
+    // every kernel this CPU can run, fastest first
+    std::vector < kernel_entry_t > supported_kernels()
+    {
+        std::vector < kernel_entry_t > kernels;
+#ifdef CRC64_X86_64
+        if (cpu_has_vpclmul_avx512()) {
+            kernels.push_back({ "vpclmul", crc64_vpclmul });
+        }
+
+        if (cpu_has_pclmul()) {
+            kernels.push_back({ "pclmul", crc64_pclmul });
+        }
+#endif // CRC64_X86_64
+
+#ifdef CRC64_AARCH64
+        if (cpu_has_pmull()) {
+            kernels.push_back({ "pmull", crc64_pmull });
+        }
+#endif // CRC64_AARCH64
+
+        kernels.push_back({ "table", crc64_table });
+        return kernels;
+    }
+
+    // the fastest kernel this CPU supports, picked on first use, CRC64_KERNEL=table|pclmul|vpclmul|pmull
+    // can narrow the choice; this may run before main(), so the warning does not go through the logger
+    const kernel_entry_t & selected_kernel()
+    {
+        static const kernel_entry_t selected = []()->kernel_entry_t
+        {
+            const auto wanted = getEnvVar("CRC64_KERNEL");
+            const auto kernels = supported_kernels();
+            for (const auto & entry : kernels)
+            {
+                if (wanted.empty() || wanted == entry.name) {
+                    return entry;
+                }
+            }
+
+            std::fprintf(stderr, "CRC64 kernel %s is not available, falling back to table\n", wanted.c_str());
+            return kernels.back();
+        }();
+
+        return selected;
+    }
+
+    // CRC-64/XZ entry point of the algorithm table, resolves the kernel on its first call so the table
+    // itself stays constant-initialized and usable from other static initializers
+    uint64_t crc64_selected(uint64_t crc, const uint8_t * data, size_t length)
+    {
+        return selected_kernel().kernel(crc, data, length);
+    }
+}
+
+namespace {
+    template < typename Engine >
+    constexpr CRC64::algorithm_t engine_algorithm(const char * name) {
+        return { name, Engine::update, Engine::shift, Engine::init, Engine::xor_out };
+    }
+
+    // only CRC-64/XZ has carry-less multiply kernels, the others run on the generic tables
+    constexpr CRC64::algorithm_t algorithms[] = {
+        { "xz", crc64_selected, crc64_xz_t::shift, crc64_xz_t::init, crc64_xz_t::xor_out },
+        engine_algorithm < crc64_ecma_182_t >("ecma-182"),
+        engine_algorithm < crc64_go_iso_t >("go-iso"),
+        engine_algorithm < crc64_nvme_t >("nvme"),
+    };
+}
+
+const CRC64::algorithm_t * CRC64::algorithm = &algorithms[0];
+
+uint64_t CRC64::combine(const uint64_t crc_a, const uint64_t crc_b, const uint64_t length_b)
+{
+    // shifting A by length_b zero bytes is a multiplication by x^(8 * length_b)
+    return algorithm->shift(crc_a ^ algorithm->xor_out ^ algorithm->init, length_b) ^ crc_b;
+}
+
+void CRC64::use_algorithm(const std::string & name)
+{
+    for (const auto & entry : algorithms)
+    {
+        if (name == entry.name) {
+            algorithm = &entry;
+            return;
+        }
+    }
+
+    throw std::runtime_error("Unknown CRC64 algorithm " + name + ", expected one of " + algorithm_names());
+}
+
+std::string CRC64::algorithm_names()
+{
+    std::string names;
+    for (const auto & entry : algorithms) {
+        names += (names.empty() ? "" : ", ") + std::string(entry.name);
+    }
+    return names;
+}
+
+unsigned int CRC64::algorithm_id()
+{
+    return static_cast<unsigned int>(algorithm - algorithms);
+}
+
+std::vector < CRC64::kernel_entry_t > CRC64::available_kernels()
+{
+    return supported_kernels();
+}
+
+const char * CRC64::kernel_name()
+{
+    return algorithm == &algorithms[0] ? selected_kernel().name : "table";
+}
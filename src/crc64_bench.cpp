@@ -0,0 +1,664 @@
+/* crc64_bench.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+/*
+ * crc64_bench: micro benchmarks of the CRC64 kernels, the other CRC-64 variants, the --digest
+ * digests and the I/O engines, and macro benchmarks that run crc64sum itself on generated
+ * workloads. Results are written as JSON in the layout of Google Benchmark, so runs of two
+ * builds can be compared with its tools/compare.py or a plain diff.
+ */
+
+#include "argument_parser.h"
+#include "crc64.h"
+#include "crc64_engine.h"
+#include "digest.h"
+#include "file_reader.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char ** environ;
+
+Arguments::predefined_args_t arguments = {
+    Arguments::single_arg_t {
+        .name = "filter",
+        .short_name = 'f',
+        .value_required = true,
+        .explanation = "Only run benchmarks whose name matches this regular expression"
+    },
+    Arguments::single_arg_t {
+        .name = "min-time",
+        .short_name = 'm',
+        .value_required = true,
+        .explanation = "Minimum seconds each micro benchmark runs for (default 0.1)"
+    },
+    Arguments::single_arg_t {
+        .name = "repetitions",
+        .short_name = 'r',
+        .value_required = true,
+        .explanation = "Runs of each macro benchmark, the mean is reported (default 3)"
+    },
+    Arguments::single_arg_t {
+        .name = "out",
+        .short_name = 'o',
+        .value_required = true,
+        .explanation = "Write the JSON results to this file instead of STDOUT"
+    },
+    Arguments::single_arg_t {
+        .name = "dir",
+        .short_name = 'd',
+        .value_required = true,
+        .explanation = "Directory for the generated workloads (default a new one under the temporary directory)"
+    },
+    Arguments::single_arg_t {
+        .name = "crc64sum",
+        .short_name = 'c',
+        .value_required = true,
+        .explanation = "crc64sum executable the macro benchmarks run (default the one built alongside)"
+    },
+    Arguments::single_arg_t {
+        .name = "quick",
+        .short_name = 'q',
+        .value_required = false,
+        .explanation = "Shrink the macro workloads about tenfold, for a smoke test"
+    },
+    Arguments::single_arg_t {
+        .name = "help",
+        .short_name = 'h',
+        .value_required = false,
+        .explanation = "Show this help message"
+    },
+};
+
+namespace {
+    struct result_t {
+        std::string name;
+        uint64_t iterations = 0;
+        double real_time = 0;   // ns per iteration
+        double cpu_time = 0;    // ns per iteration, including child processes
+        uint64_t bytes = 0;     // per iteration
+        uint64_t items = 0;     // per iteration
+    };
+
+    double cpu_seconds()
+    {
+        double seconds = 0;
+        for (const int who : { RUSAGE_SELF, RUSAGE_CHILDREN })
+        {
+            rusage usage { };
+            getrusage(who, &usage);
+            seconds += static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+                + static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+        }
+        return seconds;
+    }
+
+    double wall_seconds()
+    {
+        return std::chrono::duration < double >(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // keeps results alive, so the compiler cannot drop the work that produced them
+    volatile uint64_t sink;
+
+    class Bench {
+    private:
+        std::regex filter;
+        double min_time;
+        unsigned int repetitions;
+        std::vector < result_t > results;
+
+        void report(const result_t & result)
+        {
+            std::cerr << std::left << std::setw(48) << result.name << std::right
+                      << std::setw(14) << std::fixed << std::setprecision(0) << result.real_time << " ns";
+            if (result.bytes != 0) {
+                std::cerr << std::setw(12) << std::setprecision(1)
+                          << static_cast<double>(result.bytes) / result.real_time * 1e9 / (1024 * 1024) << " MiB/s";
+            }
+            std::cerr << std::endl;
+            results.push_back(result);
+        }
+
+    public:
+        Bench(const std::string & filter_, const double min_time_, const unsigned int repetitions_)
+            : filter(filter_), min_time(min_time_), repetitions(repetitions_)
+        { }
+
+        [[nodiscard]] bool wanted(const std::string & name) const {
+            return std::regex_search(name, filter);
+        }
+
+        /*
+         * Micro benchmark: body(n) runs n iterations, n grows until one call lasts min_time,
+         * the way Google Benchmark sizes its runs. bytes and items are per iteration.
+         */
+        template < typename Body >
+        void run(const std::string & name, const uint64_t bytes, const uint64_t items, Body && body)
+        {
+            if (!wanted(name)) {
+                return;
+            }
+
+            for (uint64_t iterations = 1; ; )
+            {
+                const double cpu_start = cpu_seconds();
+                const double start = wall_seconds();
+                body(iterations);
+                const double elapsed = wall_seconds() - start;
+                const double cpu = cpu_seconds() - cpu_start;
+
+                if (elapsed >= min_time || iterations >= 1000000000)
+                {
+                    report(result_t {
+                        .name = name,
+                        .iterations = iterations,
+                        .real_time = elapsed / static_cast<double>(iterations) * 1e9,
+                        .cpu_time = cpu / static_cast<double>(iterations) * 1e9,
+                        .bytes = bytes,
+                        .items = items,
+                    });
+                    return;
+                }
+
+                // aim a little past min_time, but grow at most tenfold per round
+                const double factor = std::min(10.0, std::max(1.5, min_time * 1.4 / std::max(elapsed, 1e-9)));
+                iterations = static_cast<uint64_t>(static_cast<double>(iterations) * factor) + 1;
+            }
+        }
+
+        // macro benchmark: setup() is not timed, body() runs once per repetition
+        void run_once(const std::string & name, const uint64_t bytes, const uint64_t items,
+            const std::function < void() > & setup, const std::function < void() > & body)
+        {
+            if (!wanted(name)) {
+                return;
+            }
+
+            double elapsed = 0;
+            double cpu = 0;
+            for (unsigned int i = 0; i < repetitions; ++i)
+            {
+                setup();
+                const double cpu_start = cpu_seconds();
+                const double start = wall_seconds();
+                body();
+                elapsed += wall_seconds() - start;
+                cpu += cpu_seconds() - cpu_start;
+            }
+
+            report(result_t {
+                .name = name,
+                .iterations = repetitions,
+                .real_time = elapsed / repetitions * 1e9,
+                .cpu_time = cpu / repetitions * 1e9,
+                .bytes = bytes,
+                .items = items,
+            });
+        }
+
+        void write_json(std::ostream & out) const
+        {
+            char date[64] { };
+            const std::time_t now = std::time(nullptr);
+            std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+            char host[256] { };
+            gethostname(host, sizeof(host) - 1);
+
+            out << std::setprecision(17)
+                << "{\n"
+                << "  \"context\": {\n"
+                << "    \"date\": \"" << date << "\",\n"
+                << "    \"host_name\": \"" << host << "\",\n"
+                << "    \"executable\": \"crc64_bench\",\n"
+                << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+                << "    \"crc64_version\": \"" << CRC64_VERSION << "\",\n"
+                << "    \"crc64_kernel\": \"" << CRC64::kernel_name() << "\",\n"
+#ifdef __DEBUG__
+                << "    \"library_build_type\": \"debug\"\n"
+#else
+                << "    \"library_build_type\": \"release\"\n"
+#endif // __DEBUG__
+                << "  },\n"
+                << "  \"benchmarks\": [";
+
+            for (size_t i = 0; i < results.size(); ++i)
+            {
+                const auto & result = results[i];
+                out << (i == 0 ? "\n" : ",\n")
+                    << "    {\n"
+                    << "      \"name\": \"" << result.name << "\",\n"
+                    << "      \"run_name\": \"" << result.name << "\",\n"
+                    << "      \"run_type\": \"iteration\",\n"
+                    << "      \"iterations\": " << result.iterations << ",\n"
+                    << "      \"real_time\": " << result.real_time << ",\n"
+                    << "      \"cpu_time\": " << result.cpu_time << ",\n"
+                    << "      \"time_unit\": \"ns\"";
+                if (result.bytes != 0) {
+                    out << ",\n      \"bytes_per_second\": " << static_cast<double>(result.bytes) / result.real_time * 1e9;
+                }
+                if (result.items != 0) {
+                    out << ",\n      \"items_per_second\": " << static_cast<double>(result.items) / result.real_time * 1e9;
+                }
+                out << "\n    }";
+            }
+
+            out << "\n  ]\n}\n";
+        }
+    };
+
+    // run a program to completion with STDOUT sent to stdout_path, throws unless it exits with 0
+    void run_program(const std::vector < std::string > & argv, const std::string & stdout_path = "/dev/null")
+    {
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, stdout_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+        std::vector < char * > raw;
+        for (const auto & arg : argv) {
+            raw.push_back(const_cast<char *>(arg.c_str()));
+        }
+        raw.push_back(nullptr);
+
+        pid_t pid = 0;
+        const int error = posix_spawn(&pid, raw[0], &actions, nullptr, raw.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        if (error != 0) {
+            errno = error;
+            throw std::runtime_error("Cannot run " + argv[0]);
+        }
+
+        int status = 0;
+        if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            throw std::runtime_error("Benchmarked command failed: " + argv[0]);
+        }
+    }
+
+    // drop a file, or every file below a directory, from the page cache
+    void evict(const std::filesystem::path & path)
+    {
+        auto evict_file = [](const std::filesystem::path & file)
+        {
+            const int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd >= 0) {
+                fdatasync(fd);
+                posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+                close(fd);
+            }
+        };
+
+        if (!std::filesystem::is_directory(path)) {
+            evict_file(path);
+            return;
+        }
+
+        for (const auto & entry : std::filesystem::recursive_directory_iterator(path)) {
+            if (entry.is_regular_file()) {
+                evict_file(entry.path());
+            }
+        }
+    }
+
+    void write_random_file(const std::filesystem::path & path, const uint64_t size, std::mt19937_64 & random)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        std::vector < uint64_t > block(64 * 1024);
+        for (uint64_t written = 0; written < size; )
+        {
+            std::ranges::generate(block, std::ref(random));
+            const auto length = std::min<uint64_t>(size - written, block.size() * sizeof(uint64_t));
+            file.write(reinterpret_cast<const char *>(block.data()), static_cast<std::streamsize>(length));
+            written += length;
+        }
+
+        if (!file) {
+            throw std::runtime_error("Cannot write " + path.string());
+        }
+    }
+
+    std::string size_name(const uint64_t size)
+    {
+        if (size >= 1024 * 1024 && size % (1024 * 1024) == 0) {
+            return std::to_string(size >> 20) + "M";
+        }
+        if (size >= 1024 && size % 1024 == 0) {
+            return std::to_string(size >> 10) + "K";
+        }
+        return std::to_string(size);
+    }
+
+    constexpr uint64_t max_buffer_size = 64 * 1024 * 1024;
+
+    void kernel_benchmarks(Bench & bench, const uint8_t * buffer)
+    {
+        for (const auto & [name, kernel] : CRC64::available_kernels()) {
+            for (uint64_t size = 16; size <= max_buffer_size; size *= 4) {
+                for (const size_t offset : { 0, 1, 3, 8 })
+                {
+                    bench.run("kernel/" + std::string(name) + "/" + size_name(size) + "/offset:" + std::to_string(offset),
+                        size, 0, [&, kernel_ = kernel](const uint64_t iterations) {
+                            uint64_t crc = ~0ULL;
+                            for (uint64_t i = 0; i < iterations; ++i) {
+                                crc = kernel_(crc, buffer + offset, size);
+                            }
+                            sink = crc;
+                        });
+                }
+            }
+        }
+    }
+
+    template < typename Engine >
+    void engine_benchmark(Bench & bench, const std::string & name, const uint8_t * buffer)
+    {
+        for (const uint64_t size : { 4096ULL, 1024ULL * 1024 })
+        {
+            bench.run("engine/" + name + "/" + size_name(size), size, 0, [&](const uint64_t iterations) {
+                uint64_t crc = Engine::init;
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    crc = Engine::update(crc, buffer, size);
+                }
+                sink = crc;
+            });
+        }
+    }
+
+    void digest_benchmarks(Bench & bench, const uint8_t * buffer)
+    {
+        for (const auto & [name, kind] : { std::pair { "crc32c", digest::CRC32C_DIGEST },
+                                           std::pair { "xxh64", digest::XXH64_DIGEST } })
+        {
+            for (const uint64_t size : { 4096ULL, 1024ULL * 1024 })
+            {
+                bench.run("digest/" + std::string(name) + "/" + size_name(size), size, 0, [&](const uint64_t iterations) {
+                    digest::Extras extras({ kind });
+                    for (uint64_t i = 0; i < iterations; ++i) {
+                        extras.update(buffer, size);
+                    }
+                    sink = extras.values().front();
+                });
+            }
+        }
+    }
+
+    // the read path of crc64sum for one regular file, per I/O engine, on a warm and a cold page cache
+    void io_benchmarks(Bench & bench, const std::filesystem::path & file, const uint64_t size)
+    {
+        const std::pair < const char *, file_reader::engine_t > engines[] = {
+            { "mmap", file_reader::MMAP }, { "uring", file_reader::URING },
+            { "direct", file_reader::DIRECT }, { "stream", file_reader::STREAM },
+        };
+
+        for (const auto & [engine_name, engine] : engines) {
+            for (const bool cold : { false, true })
+            {
+                const auto name = "file/" + std::string(engine_name) + "/" + (cold ? "cold" : "warm") + "/" + size_name(size);
+                file_reader::options_t options;
+                options.engine = engine;
+                bench.run_once(name, size, 1,
+                    [&] {
+                        if (cold) {
+                            evict(file);
+                        } else {
+                            file_reader::read_regular_file(options, file, 0, size, [](const uint8_t *, size_t) { });
+                        }
+                    },
+                    [&] {
+                        CRC64 crc64;
+                        auto update = [&crc64](const uint8_t * data, const size_t length) { crc64.update(data, length); };
+                        if (!file_reader::read_regular_file(options, file, 0, size, update))
+                        {
+                            std::ifstream stream(file, std::ios::binary);
+                            file_reader::read_stream(stream, update, options.block_size, size);
+                        }
+                        sink = crc64.get_checksum();
+                    });
+            }
+        }
+    }
+}
+
+int main(int argc, const char ** argv)
+{
+    try
+    {
+        const Arguments args(argc, argv, arguments);
+        const auto arg_value_ref = static_cast<Arguments::args_t>(args);
+        if (arg_value_ref.contains("help")) {
+            std::cout << *argv << " [OPTIONS]" << std::endl;
+            args.print_help();
+            return EXIT_SUCCESS;
+        }
+
+        auto value_of = [&arg_value_ref](const std::string & name, const std::string & fallback)->std::string {
+            return arg_value_ref.contains(name) ? arg_value_ref.at(name).back() : fallback;
+        };
+
+        Bench bench(value_of("filter", ""), std::stod(value_of("min-time", "0.1")),
+            static_cast<unsigned int>(std::max(1, std::stoi(value_of("repetitions", "3")))));
+        const std::string crc64sum = value_of("crc64sum", CRC64SUM_PATH);
+        const bool quick = arg_value_ref.contains("quick");
+
+        // micro benchmarks, over one random buffer with room for the largest size at any offset
+        {
+            std::vector < uint8_t > storage(max_buffer_size + 128);
+            auto * buffer = reinterpret_cast<uint8_t *>((reinterpret_cast<uintptr_t>(storage.data()) + 63) & ~uintptr_t { 63 });
+            std::mt19937_64 random(42);
+            std::ranges::generate(storage, [&random] { return static_cast<uint8_t>(random()); });
+
+            kernel_benchmarks(bench, buffer);
+            engine_benchmark < crc64_xz_t >(bench, "xz", buffer);
+            engine_benchmark < crc64_ecma_182_t >(bench, "ecma-182", buffer);
+            engine_benchmark < crc64_go_iso_t >(bench, "go-iso", buffer);
+            engine_benchmark < crc64_nvme_t >(bench, "nvme", buffer);
+            digest_benchmarks(bench, buffer);
+
+            bench.run("combine/1G", 0, 1, [](const uint64_t iterations) {
+                uint64_t crc = 1;
+                for (uint64_t i = 0; i < iterations; ++i) {
+                    crc = CRC64::combine(crc, i, 1ULL << 30);
+                }
+                sink = crc;
+            });
+        }
+
+        // macro benchmarks on generated workloads
+        std::filesystem::path dir;
+        bool remove_dir = false;
+        if (arg_value_ref.contains("dir")) {
+            dir = arg_value_ref.at("dir").back();
+            std::filesystem::create_directories(dir);
+        } else {
+            auto pattern = (std::filesystem::temp_directory_path() / "crc64_bench.XXXXXX").string();
+            if (!mkdtemp(pattern.data())) {
+                throw std::runtime_error("Cannot create a workload directory");
+            }
+            dir = pattern;
+            remove_dir = true;
+        }
+
+        const uint64_t small_count = quick ? 1000 : 10000;
+        const uint64_t small_size = 4096;
+        const uint64_t huge_count = 4;
+        const uint64_t huge_size = (quick ? 32ULL : 256ULL) * 1024 * 1024;
+        const uint64_t manifest_entries = quick ? 100000 : 1000000;
+        // heterogeneous tree: a few large files of different sizes among many small ones of 1 to 64 KiB
+        const uint64_t mixed_large_count = 3;
+        const uint64_t mixed_large_size = (quick ? 16ULL : 128ULL) * 1024 * 1024;
+        const uint64_t mixed_small_count = quick ? 500 : 5000;
+
+        // --jobs values the mixed tree is hashed with, doubling up to one per hardware thread
+        std::vector < unsigned int > job_counts;
+        const unsigned int hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        for (unsigned int jobs = 1; jobs < hardware_threads; jobs *= 2) {
+            job_counts.push_back(jobs);
+        }
+        job_counts.push_back(hardware_threads);
+
+        try
+        {
+            std::mt19937_64 random(42);
+            const auto small_dir = dir / "small";
+            const auto huge_dir = dir / "huge";
+            const auto mixed_dir = dir / "mixed";
+            const bool need_small = bench.wanted("crc64sum/many_small") || bench.wanted("crc64sum/verify");
+            const bool need_huge = bench.wanted("file/") || bench.wanted("crc64sum/few_huge");
+
+            if (need_small)
+            {
+                std::filesystem::create_directories(small_dir);
+                for (uint64_t i = 0; i < small_count; ++i) {
+                    write_random_file(small_dir / ("f" + std::to_string(i)), small_size, random);
+                }
+            }
+
+            std::vector < std::string > huge_files;
+            if (need_huge)
+            {
+                std::filesystem::create_directories(huge_dir);
+                for (uint64_t i = 0; i < huge_count; ++i) {
+                    huge_files.push_back((huge_dir / ("h" + std::to_string(i))).string());
+                    write_random_file(huge_files.back(), huge_size, random);
+                }
+                io_benchmarks(bench, huge_files.front(), huge_size);
+            }
+
+            uint64_t mixed_bytes = 0;
+            if (bench.wanted("crc64sum/mixed"))
+            {
+                std::filesystem::create_directories(mixed_dir);
+                for (uint64_t i = 0; i < mixed_large_count; ++i) {
+                    const uint64_t size = mixed_large_size >> i;
+                    write_random_file(mixed_dir / ("l" + std::to_string(i)), size, random);
+                    mixed_bytes += size;
+                }
+                for (uint64_t i = 0; i < mixed_small_count; ++i) {
+                    const uint64_t size = 1024 + random() % (64 * 1024);
+                    write_random_file(mixed_dir / ("s" + std::to_string(i)), size, random);
+                    mixed_bytes += size;
+                }
+            }
+
+            for (const bool cold : { false, true })
+            {
+                const std::string cache = cold ? "cold" : "warm";
+                auto prepare = [&cold](const std::filesystem::path & path) {
+                    return [cold, path] { if (cold) { evict(path); } };
+                };
+
+                bench.run_once("crc64sum/many_small/" + cache + "/" + std::to_string(small_count), small_count * small_size,
+                    small_count, prepare(small_dir),
+                    [&] { run_program({ crc64sum, "-j", "0", "-r", small_dir.string() }); });
+
+                std::vector < std::string > command = { crc64sum, "-j", "0" };
+                command.insert(command.end(), huge_files.begin(), huge_files.end());
+                bench.run_once("crc64sum/few_huge/" + cache + "/" + std::to_string(huge_count) + "x" + size_name(huge_size),
+                    huge_count * huge_size, huge_count, prepare(huge_dir),
+                    [&] { run_program(command); });
+
+                // scaling of the multi-file scheduler, compare the j<N> results against j1
+                for (const auto jobs : job_counts)
+                {
+                    bench.run_once("crc64sum/mixed/" + cache + "/j" + std::to_string(jobs), mixed_bytes,
+                        mixed_large_count + mixed_small_count, prepare(mixed_dir),
+                        [&] { run_program({ crc64sum, "-j", std::to_string(jobs), "-r", mixed_dir.string() }); });
+                }
+            }
+
+            if (bench.wanted("crc64sum/verify"))
+            {
+                // the small files listed over and over until the manifest has manifest_entries lines
+                const auto sums = (dir / "small.sums").string();
+                run_program({ crc64sum, "-r", small_dir.string() }, sums);
+                std::vector < std::string > lines;
+                {
+                    std::ifstream in(sums);
+                    for (std::string line; std::getline(in, line); ) {
+                        lines.push_back(std::move(line));
+                    }
+                }
+
+                const auto text_manifest = (dir / "manifest.txt").string();
+                const auto binary_manifest = (dir / "manifest.bin").string();
+                {
+                    std::ofstream out(text_manifest, std::ios::trunc);
+                    for (uint64_t i = 0; i < manifest_entries; ++i) {
+                        out << lines[i % lines.size()] << '\n';
+                    }
+                }
+                run_program({ crc64sum, "-I", "-M", binary_manifest, text_manifest });
+
+                for (const auto & [format, manifest] : { std::pair { "text", text_manifest },
+                                                         std::pair { "binary", binary_manifest } })
+                {
+                    bench.run_once("crc64sum/verify/" + std::string(format) + "/" + std::to_string(manifest_entries),
+                        manifest_entries * small_size, manifest_entries, [] { },
+                        [&] { run_program({ crc64sum, "-j", "0", "-c", manifest }); });
+                }
+            }
+        } catch (...) {
+            if (remove_dir) {
+                std::filesystem::remove_all(dir);
+            }
+            throw;
+        }
+
+        if (remove_dir) {
+            std::filesystem::remove_all(dir);
+        }
+
+        if (arg_value_ref.contains("out")) {
+            std::ofstream out(arg_value_ref.at("out").back(), std::ios::trunc);
+            bench.write_json(out);
+            if (!out) {
+                throw std::runtime_error("Cannot write " + arg_value_ref.at("out").back());
+            }
+        } else {
+            bench.write_json(std::cout);
+        }
+
+        return EXIT_SUCCESS;
+    } catch (std::exception & e) {
+        std::cerr << "ERROR: " << e.what() << ": " << std::strerror(errno) << std::endl;
+        return EXIT_FAILURE;
+    }
+}
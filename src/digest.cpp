@@ -0,0 +1,307 @@
+/* digest.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "digest.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+# include <immintrin.h>
+# define DIGEST_SSE42
+#elif defined(__aarch64__) && defined(__linux__) && (defined(__GNUC__) || defined(__clang__))
+# include <arm_acle.h>
+# include <sys/auxv.h>
+# include <asm/hwcap.h>
+# define DIGEST_ARM_CRC
+#endif
+
+namespace digest {
+    namespace {
+        // bit-reflected Castagnoli polynomial
+        constexpr uint32_t crc32c_poly = 0x82F63B78;
+
+        using crc32c_table_t = std::array < std::array < uint32_t, 256 >, 8 >;
+
+        constexpr crc32c_table_t make_crc32c_tables()
+        {
+            crc32c_table_t result {};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t crc = i;
+                for (int j = 0; j < 8; ++j) {
+                    crc = (crc & 1) ? (crc >> 1) ^ crc32c_poly : (crc >> 1);
+                }
+                result[0][i] = crc;
+            }
+
+            for (uint32_t i = 0; i < 256; ++i) {
+                for (size_t k = 1; k < result.size(); ++k) {
+                    result[k][i] = result[0][result[k - 1][i] & 0xFF] ^ (result[k - 1][i] >> 8);
+                }
+            }
+
+            return result;
+        }
+
+        constexpr crc32c_table_t crc32c_tables = make_crc32c_tables();
+
+        uint64_t load_le64(const uint8_t * data)
+        {
+            uint64_t word;
+            std::memcpy(&word, data, sizeof(word));
+            if constexpr (std::endian::native == std::endian::big) {
+                word = std::byteswap(word);
+            }
+            return word;
+        }
+
+        uint32_t load_le32(const uint8_t * data)
+        {
+            uint32_t word;
+            std::memcpy(&word, data, sizeof(word));
+            if constexpr (std::endian::native == std::endian::big) {
+                word = std::byteswap(word);
+            }
+            return word;
+        }
+
+        uint32_t crc32c_table(uint32_t crc, const uint8_t * data, size_t length)
+        {
+            const auto & table = crc32c_tables;
+            while (length >= 8)
+            {
+                const uint64_t word = load_le64(data) ^ crc;
+                crc = table[7][word & 0xFF]         ^ table[6][(word >> 8) & 0xFF]
+                    ^ table[5][(word >> 16) & 0xFF] ^ table[4][(word >> 24) & 0xFF]
+                    ^ table[3][(word >> 32) & 0xFF] ^ table[2][(word >> 40) & 0xFF]
+                    ^ table[1][(word >> 48) & 0xFF] ^ table[0][word >> 56];
+                data += 8;
+                length -= 8;
+            }
+
+            while (length--) {
+                crc = table[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+            }
+
+            return crc;
+        }
+
+#ifdef DIGEST_SSE42
+        __attribute__((target("sse4.2")))
+        uint32_t crc32c_sse42(uint32_t crc, const uint8_t * data, size_t length)
+        {
+            uint64_t crc64 = crc;
+            for (; length >= 8; data += 8, length -= 8) {
+                crc64 = _mm_crc32_u64(crc64, load_le64(data));
+            }
+
+            crc = static_cast<uint32_t>(crc64);
+            while (length--) {
+                crc = _mm_crc32_u8(crc, *data++);
+            }
+
+            return crc;
+        }
+
+        const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+#endif // DIGEST_SSE42
+
+#ifdef DIGEST_ARM_CRC
+        __attribute__((target("+crc")))
+        uint32_t crc32c_arm(uint32_t crc, const uint8_t * data, size_t length)
+        {
+            for (; length >= 8; data += 8, length -= 8) {
+                crc = __crc32cd(crc, load_le64(data));
+            }
+
+            while (length--) {
+                crc = __crc32cb(crc, *data++);
+            }
+
+            return crc;
+        }
+
+        const bool has_arm_crc = (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+#endif // DIGEST_ARM_CRC
+
+        constexpr uint64_t prime64_1 = 0x9E3779B185EBCA87ULL;
+        constexpr uint64_t prime64_2 = 0xC2B2AE3D27D4EB4FULL;
+        constexpr uint64_t prime64_3 = 0x165667B19E3779F9ULL;
+        constexpr uint64_t prime64_4 = 0x85EBCA77C2B2AE63ULL;
+        constexpr uint64_t prime64_5 = 0x27D4EB2F165667C5ULL;
+
+        uint64_t xxh64_round(uint64_t lane, const uint64_t input)
+        {
+            lane += input * prime64_2;
+            lane = std::rotl(lane, 31);
+            return lane * prime64_1;
+        }
+
+        uint64_t xxh64_merge(uint64_t hash, const uint64_t lane)
+        {
+            hash ^= xxh64_round(0, lane);
+            return hash * prime64_1 + prime64_4;
+        }
+    }
+
+    kind_t kind_from_name(const std::string & name)
+    {
+        if (name == "crc32c") {
+            return CRC32C_DIGEST;
+        }
+
+        if (name == "xxh64") {
+            return XXH64_DIGEST;
+        }
+
+        throw std::runtime_error("Unknown digest " + name);
+    }
+
+    size_t hex_width(const kind_t kind)
+    {
+        return kind == CRC32C_DIGEST ? 8 : 16;
+    }
+
+    void CRC32C::update(const uint8_t * data, const size_t length)
+    {
+#ifdef DIGEST_SSE42
+        if (has_sse42) {
+            crc32c_value = crc32c_sse42(crc32c_value, data, length);
+            return;
+        }
+#endif // DIGEST_SSE42
+
+#ifdef DIGEST_ARM_CRC
+        if (has_arm_crc) {
+            crc32c_value = crc32c_arm(crc32c_value, data, length);
+            return;
+        }
+#endif // DIGEST_ARM_CRC
+
+        crc32c_value = crc32c_table(crc32c_value, data, length);
+    }
+
+    XXH64::XXH64()
+        : lanes { prime64_1 + prime64_2, prime64_2, 0, 0 - prime64_1 }
+    { }
+
+    void XXH64::consume(const uint8_t * stripe)
+    {
+        for (int i = 0; i < 4; ++i) {
+            lanes[i] = xxh64_round(lanes[i], load_le64(stripe + 8 * i));
+        }
+    }
+
+    void XXH64::update(const uint8_t * data, size_t length)
+    {
+        total_length += length;
+        if (pending_length != 0)
+        {
+            const size_t fill = std::min(sizeof(pending) - pending_length, length);
+            std::memcpy(pending + pending_length, data, fill);
+            pending_length += fill;
+            data += fill;
+            length -= fill;
+            if (pending_length < sizeof(pending)) {
+                return;
+            }
+            consume(pending);
+            pending_length = 0;
+        }
+
+        for (; length >= sizeof(pending); data += sizeof(pending), length -= sizeof(pending)) {
+            consume(data);
+        }
+
+        std::memcpy(pending, data, length);
+        pending_length = length;
+    }
+
+    uint64_t XXH64::get_checksum() const
+    {
+        uint64_t hash;
+        if (total_length >= sizeof(pending)) {
+            hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+            for (const uint64_t lane : lanes) {
+                hash = xxh64_merge(hash, lane);
+            }
+        } else {
+            hash = prime64_5;
+        }
+        hash += total_length;
+
+        const uint8_t * data = pending;
+        size_t length = pending_length;
+        for (; length >= 8; data += 8, length -= 8) {
+            hash ^= xxh64_round(0, load_le64(data));
+            hash = std::rotl(hash, 27) * prime64_1 + prime64_4;
+        }
+
+        if (length >= 4) {
+            hash ^= static_cast<uint64_t>(load_le32(data)) * prime64_1;
+            hash = std::rotl(hash, 23) * prime64_2 + prime64_3;
+            data += 4;
+            length -= 4;
+        }
+
+        while (length--) {
+            hash ^= *data++ * prime64_5;
+            hash = std::rotl(hash, 11) * prime64_1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= prime64_2;
+        hash ^= hash >> 29;
+        hash *= prime64_3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+    Extras::Extras(const std::vector < kind_t > & kinds_) : kinds(kinds_)
+    {
+        for (const auto kind : kinds) {
+            (kind == CRC32C_DIGEST ? want_crc32c : want_xxh64) = true;
+        }
+    }
+
+    void Extras::update(const uint8_t * data, const size_t length)
+    {
+        if (want_crc32c) {
+            crc32c.update(data, length);
+        }
+        if (want_xxh64) {
+            xxh64.update(data, length);
+        }
+    }
+
+    std::vector < uint64_t > Extras::values() const
+    {
+        std::vector < uint64_t > result;
+        result.reserve(kinds.size());
+        for (const auto kind : kinds) {
+            result.push_back(kind == CRC32C_DIGEST ? crc32c.get_checksum() : xxh64.get_checksum());
+        }
+        return result;
+    }
+}
@@ -0,0 +1,308 @@
+/* directory_walker.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "directory_walker.h"
+#include "log.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#ifdef __linux__
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/syscall.h>
+# include <dirent.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif // __linux__
+
+namespace directory_walker {
+#ifdef __linux__
+    namespace {
+        class directory_descriptor_t {
+        public:
+            int fd;
+            explicit directory_descriptor_t(const int fd_) : fd(fd_) { }
+            ~directory_descriptor_t() {
+                if (fd >= 0) {
+                    close(fd);
+                }
+            }
+            directory_descriptor_t(const directory_descriptor_t &) = delete;
+            directory_descriptor_t & operator=(const directory_descriptor_t &) = delete;
+        };
+
+        // a directory and all directories above it, shared by their children, to tell symbolic link cycles apart
+        struct ancestor_t {
+            dev_t device;
+            ino_t inode;
+            std::shared_ptr < const ancestor_t > parent;
+        };
+
+        // directories are queued by path, holding descriptors for all of them could run out of those
+        struct directory_t {
+            std::string path;
+            bool root = false;  // roots are named on the command line and followed even if they are links
+            std::shared_ptr < const ancestor_t > ancestors;     // only kept when following symbolic links
+        };
+
+        bool is_ancestor(const ancestor_t * ancestor, const struct stat & info)
+        {
+            for (; ancestor; ancestor = ancestor->parent.get())
+            {
+                if (ancestor->device == info.st_dev && ancestor->inode == info.st_ino) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        class walker_t {
+            struct worker_queue_t {
+                std::mutex mutex;
+                std::deque < directory_t > directories;
+            };
+
+            const options_t & options;
+            dev_t root_device = 0;
+            std::vector < std::unique_ptr < worker_queue_t > > queues;
+            std::vector < std::vector < std::string > > files;  // per worker, merged at the end
+            std::atomic < uint64_t > pending { 0 };             // directories queued or being read
+            std::atomic < uint64_t > queued { 0 };              // directories waiting in a queue
+            std::mutex idle_mutex;
+            std::condition_variable idle_cv;
+
+            void push(const size_t worker, directory_t directory)
+            {
+                ++pending;
+                {
+                    std::lock_guard<std::mutex> lock(queues[worker]->mutex);
+                    queues[worker]->directories.push_back(std::move(directory));
+                }
+                ++queued;
+                {
+                    std::lock_guard<std::mutex> lock(idle_mutex);
+                }
+                idle_cv.notify_one();
+            }
+
+            // newest of our own directories first, the oldest of somebody else's when we have none
+            bool pop(const size_t worker, directory_t & directory)
+            {
+                for (size_t i = 0; i < queues.size(); ++i)
+                {
+                    auto & queue = *queues[(worker + i) % queues.size()];
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+                    if (queue.directories.empty()) {
+                        continue;
+                    }
+
+                    if (i == 0) {
+                        directory = std::move(queue.directories.back());
+                        queue.directories.pop_back();
+                    } else {
+                        directory = std::move(queue.directories.front());
+                        queue.directories.pop_front();
+                    }
+                    --queued;
+                    return true;
+                }
+
+                return false;
+            }
+
+            void read_directory(const size_t worker, const directory_t & directory)
+            {
+                const directory_descriptor_t dir(open(directory.path.c_str(),
+                    O_RDONLY | O_DIRECTORY | O_CLOEXEC | (options.follow_symlinks || directory.root ? 0 : O_NOFOLLOW)));
+                struct stat dir_info { };
+                if (dir.fd < 0 || fstat(dir.fd, &dir_info) != 0) {
+                    debug::log(debug::to_stderr, debug::warning_log, "Cannot open directory ", directory.path, "\n");
+                    return;
+                }
+
+                if (options.one_file_system && dir_info.st_dev != root_device) {
+                    return;
+                }
+
+                // a link back to this directory or one above it would be walked forever, other links are walked
+                // every time they are reached, like any other directory
+                std::shared_ptr < const ancestor_t > self;
+                if (options.follow_symlinks) {
+                    self = std::make_shared < const ancestor_t >(dir_info.st_dev, dir_info.st_ino, directory.ancestors);
+                }
+
+                const std::string prefix = directory.path.ends_with('/') ? directory.path : directory.path + "/";
+                thread_local std::vector < char > buffer(64 * 1024);
+                while (true)
+                {
+                    const auto length = syscall(SYS_getdents64, dir.fd, buffer.data(), buffer.size());
+                    if (length < 0) {
+                        debug::log(debug::to_stderr, debug::warning_log, "Cannot read directory ", directory.path, "\n");
+                        return;
+                    }
+                    if (length == 0) {
+                        return;
+                    }
+
+                    for (long offset = 0; offset < length; )
+                    {
+                        const auto * entry = reinterpret_cast<const struct dirent64 *>(buffer.data() + offset);
+                        offset += entry->d_reclen;
+
+                        const std::string_view name = entry->d_name;
+                        if (name == "." || name == "..") {
+                            continue;
+                        }
+
+                        auto type = entry->d_type;
+                        if (type == DT_UNKNOWN || (type == DT_LNK && options.follow_symlinks))
+                        {
+                            // ask the file system, through the link when following them
+                            struct stat info { };
+                            if (fstatat(dir.fd, entry->d_name, &info,
+                                    options.follow_symlinks ? 0 : AT_SYMLINK_NOFOLLOW) != 0)
+                            {
+                                continue; // e.g., a dangling link
+                            }
+
+                            if (S_ISDIR(info.st_mode)) {
+                                if (type == DT_LNK && is_ancestor(self.get(), info)) {
+                                    continue;
+                                }
+                                type = DT_DIR;
+                            } else if (S_ISREG(info.st_mode)) {
+                                type = DT_REG;
+                            } else {
+                                continue;
+                            }
+                        }
+
+                        if (type == DT_REG) {
+                            files[worker].emplace_back(prefix + entry->d_name);
+                        } else if (type == DT_DIR) {
+                            push(worker, directory_t { .path = prefix + entry->d_name, .ancestors = self });
+                        }
+                    }
+                }
+            }
+
+            void worker_loop(const size_t worker)
+            {
+                while (true)
+                {
+                    if (directory_t directory; pop(worker, directory))
+                    {
+                        read_directory(worker, directory);
+                        if (--pending == 0) {
+                            std::lock_guard<std::mutex> lock(idle_mutex);
+                            idle_cv.notify_all();
+                        }
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock(idle_mutex);
+                    idle_cv.wait(lock, [this] { return pending == 0 || queued != 0; });
+                    if (pending == 0) {
+                        return;
+                    }
+                }
+            }
+
+        public:
+            explicit walker_t(const options_t & options_) : options(options_) { }
+
+            std::vector < std::string > walk(const std::string & root)
+            {
+                struct stat info { };
+                if (stat(root.c_str(), &info) != 0) {
+                    throw std::runtime_error("Cannot stat directory " + root);
+                }
+                root_device = info.st_dev;
+
+                const unsigned int threads = options.threads == 0
+                    ? std::max(std::thread::hardware_concurrency(), 1u) : options.threads;
+                for (unsigned int i = 0; i < threads; ++i) {
+                    queues.emplace_back(std::make_unique<worker_queue_t>());
+                }
+                files.resize(threads);
+
+                queues[0]->directories.push_back(directory_t { .path = root, .root = true, .ancestors = nullptr });
+                pending = 1;
+                queued = 1;
+
+                std::vector < std::thread > workers;
+                for (unsigned int i = 1; i < threads; ++i) {
+                    workers.emplace_back(&walker_t::worker_loop, this, i);
+                }
+                worker_loop(0);
+                for (auto & worker : workers) {
+                    worker.join();
+                }
+
+                std::vector < std::string > result;
+                for (auto & list : files) {
+                    result.insert(result.end(), std::make_move_iterator(list.begin()), std::make_move_iterator(list.end()));
+                }
+                std::ranges::sort(result);
+                return result;
+            }
+        };
+    }
+
+    std::vector < std::string > list_files(const std::string & root, const options_t & options)
+    {
+        walker_t walker(options);
+        return walker.walk(root);
+    }
+#else
+    // one_file_system is not available through std::filesystem
+    std::vector < std::string > list_files(const std::string & root, const options_t & options)
+    {
+        std::vector < std::string > result;
+        auto walk_options = std::filesystem::directory_options::skip_permission_denied;
+        if (options.follow_symlinks) {
+            walk_options |= std::filesystem::directory_options::follow_directory_symlink;
+        }
+
+        for (const auto & entry : std::filesystem::recursive_directory_iterator(root, walk_options))
+        {
+            if (entry.is_symlink() && !options.follow_symlinks) {
+                continue;
+            }
+            if (entry.is_regular_file()) {
+                result.emplace_back(entry.path().generic_string());
+            }
+        }
+
+        std::ranges::sort(result);
+        return result;
+    }
+#endif // __linux__
+}
@@ -0,0 +1,1071 @@
+/* file_reader.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "file_reader.h"
+
+#include "log.hpp"
+#include "stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <cstdlib>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <filesystem>
+#include <vector>
+
+#ifdef __unix__
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+# include <csignal>
+#endif // __unix__
+
+#ifdef WIN32
+# include <malloc.h>
+#endif // WIN32
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+# define FILE_READER_IO_URING
+# include <linux/io_uring.h>
+# include <sys/syscall.h>
+#endif // __linux__
+
+namespace file_reader {
+    // how much of a file is mapped at once, keeps 32-bit builds within their address space
+    constexpr uint64_t map_window_size = sizeof(void *) >= 8 ? 1024ULL * 1024 * 1024 : 64ULL * 1024 * 1024;
+
+    engine_t engine_from_name(const std::string & name)
+    {
+        if (name == "stream") {
+            return STREAM;
+        }
+
+        if (name == "mmap") {
+            return MMAP;
+        }
+
+        if (name == "uring") {
+            return URING;
+        }
+
+        if (name == "direct") {
+            return DIRECT;
+        }
+
+        throw std::invalid_argument("Unknown I/O engine " + name);
+    }
+
+    bool regular_file_size(const std::string & filename, uint64_t & size)
+    {
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(filename, ec) || ec) {
+            return false;
+        }
+
+        size = std::filesystem::file_size(filename, ec);
+        return !ec;
+    }
+
+    // blocks are aligned for O_DIRECT, which wants buffer, offset and length on logical block boundaries
+    constexpr size_t block_alignment = 4096;
+    // blocks shared between a reader thread and the hashing thread
+    constexpr size_t pipeline_depth = 4;
+
+    size_t align_up(const size_t size) {
+        return (size + block_alignment - 1) / block_alignment * block_alignment;
+    }
+
+    // aligned blocks recycled across files, so that hashing many files does not keep allocating
+    class buffer_pool_t {
+    private:
+        std::mutex mutex;
+        std::vector < std::pair < uint8_t *, size_t > > free_blocks;
+
+        static void free_block(uint8_t * block)
+        {
+#ifdef WIN32
+            _aligned_free(block);
+#else
+            std::free(block);
+#endif // WIN32
+        }
+
+    public:
+        uint8_t * acquire(const size_t size)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (const auto it = std::ranges::find_if(free_blocks,
+                        [size](const auto & block) { return block.second == size; });
+                    it != free_blocks.end())
+                {
+                    uint8_t * block = it->first;
+                    free_blocks.erase(it);
+                    return block;
+                }
+            }
+
+#ifdef WIN32
+            auto * block = static_cast<uint8_t *>(_aligned_malloc(align_up(size), block_alignment));
+#else
+            auto * block = static_cast<uint8_t *>(std::aligned_alloc(block_alignment, align_up(size)));
+#endif // WIN32
+            if (!block) {
+                throw std::bad_alloc();
+            }
+            return block;
+        }
+
+        void release(uint8_t * block, const size_t size)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            free_blocks.emplace_back(block, size);
+        }
+
+        ~buffer_pool_t()
+        {
+            for (const auto & block : free_blocks | std::views::keys) {
+                free_block(block);
+            }
+        }
+    } buffer_pool;
+
+    struct block_t {
+        uint8_t * buffer = nullptr;
+        size_t skip = 0;        // leading bytes of buffer that are not part of the requested range
+        size_t length = 0;      // useful bytes after skip, 0 ends the stream
+    };
+
+    // filled blocks travelling from one reader thread to one consumer, at most pipeline_depth at a time
+    class block_channel_t {
+    private:
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque < block_t > blocks;
+        size_t in_use = 0;
+        bool finished = false;
+        bool cancelled = false;
+        std::exception_ptr error;
+
+    public:
+        // producer side, false once the consumer gave up
+        bool wait_for_room()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return cancelled || in_use < pipeline_depth; });
+            if (cancelled) {
+                return false;
+            }
+            in_use++;
+            return true;
+        }
+
+        void push(const block_t & block)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                blocks.push_back(block);
+            }
+            cv.notify_all();
+        }
+
+        void finish(std::exception_ptr error_ = nullptr)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished = true;
+                error = std::move(error_);
+            }
+            cv.notify_all();
+        }
+
+        // consumer side, false at the end of the stream, rethrows what the producer ran into
+        bool pop(block_t & block)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            cv.wait(lock, [this] { return finished || !blocks.empty(); });
+            if (blocks.empty())
+            {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                return false;
+            }
+
+            block = blocks.front();
+            blocks.pop_front();
+            return true;
+        }
+
+        void recycle()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                in_use--;
+            }
+            cv.notify_all();
+        }
+
+        void cancel()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                cancelled = true;
+            }
+            cv.notify_all();
+        }
+
+        // whatever was produced but never consumed
+        std::deque < block_t > leftovers()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return std::move(blocks);
+        }
+    };
+
+    /*
+     * Overlap reading and hashing: a reader thread calls produce() to fill blocks of block_size
+     * while the calling thread feeds the previously filled ones to consumer, in order.
+     */
+    using producer_t = std::function < block_t(uint8_t * buffer) >;
+    void run_pipeline(const size_t block_size, const producer_t & produce, const consumer_t & consumer)
+    {
+        block_channel_t channel;
+        std::thread reader([&]()
+        {
+            while (channel.wait_for_room())
+            {
+                uint8_t * buffer = nullptr;
+                try
+                {
+                    buffer = buffer_pool.acquire(block_size);
+                    block_t block = produce(buffer);
+                    if (block.length == 0) {
+                        buffer_pool.release(buffer, block_size);
+                        channel.finish();
+                        return;
+                    }
+                    block.buffer = buffer;
+                    channel.push(block);
+                }
+                catch (...)
+                {
+                    if (buffer) {
+                        buffer_pool.release(buffer, block_size);
+                    }
+                    channel.finish(std::current_exception());
+                    return;
+                }
+            }
+        });
+
+        auto stop_reader = [&]()->void
+        {
+            channel.cancel();
+            reader.join();
+            for (const auto & block : channel.leftovers()) {
+                buffer_pool.release(block.buffer, block_size);
+            }
+        };
+
+        try
+        {
+            block_t block;
+            while (channel.pop(block))
+            {
+                try {
+                    consumer(block.buffer + block.skip, block.length);
+                } catch (...) {
+                    buffer_pool.release(block.buffer, block_size);
+                    throw;
+                }
+                buffer_pool.release(block.buffer, block_size);
+                channel.recycle();
+            }
+        }
+        catch (...)
+        {
+            stop_reader();
+            throw;
+        }
+
+        stop_reader();
+    }
+
+    /*
+     * Drive fill() until it returns 0: the first block is filled and consumed inline, so small
+     * inputs never start a reader thread, the rest goes through run_pipeline().
+     * fill() sets exhausted once it knows there is nothing left.
+     */
+    void read_blocks(const std::function < size_t(uint8_t *) > & fill, const bool & exhausted,
+        const consumer_t & consumer, const size_t block_size)
+    {
+        uint8_t * first = buffer_pool.acquire(block_size);
+        try
+        {
+            if (const auto size = fill(first); size != 0) {
+                consumer(first, size);
+            }
+        }
+        catch (...)
+        {
+            buffer_pool.release(first, block_size);
+            throw;
+        }
+        buffer_pool.release(first, block_size);
+
+        if (exhausted) {
+            return;
+        }
+
+        run_pipeline(block_size, [&](uint8_t * buffer)->block_t {
+            return { .buffer = nullptr, .skip = 0, .length = fill(buffer) };
+        }, consumer);
+    }
+
+    uint64_t read_stream(std::istream & stream, const consumer_t & consumer, const size_t block_size,
+        const uint64_t limit)
+    {
+        uint64_t total = 0;
+        bool exhausted = false;
+        auto fill = [&](uint8_t * buffer)->size_t
+        {
+            const auto wanted = std::min<uint64_t>(block_size, limit - total);
+            if (wanted == 0 || !stream) {
+                exhausted = true;
+                return 0;
+            }
+
+            stream.read(reinterpret_cast<char *>(buffer), static_cast<std::streamsize>(wanted));
+            stats::count_read_call();
+            const auto size = static_cast<size_t>(std::max<std::streamsize>(stream.gcount(), 0));
+            total += size;
+            exhausted = !stream || total == limit;
+            return size;
+        };
+
+        read_blocks(fill, exhausted, consumer, block_size);
+        return total;
+    }
+
+#ifdef __unix__
+    class file_descriptor_t {
+    public:
+        int fd;
+        explicit file_descriptor_t(const int fd_) : fd(fd_) { }
+        ~file_descriptor_t() {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+        file_descriptor_t(const file_descriptor_t &) = delete;
+        file_descriptor_t & operator=(const file_descriptor_t &) = delete;
+    };
+
+    /*
+     * Pages of a mapped file that was truncated meanwhile fault with SIGBUS. The handler maps zeros over
+     * what is left of the window this thread is consuming, so the consumer runs to its end, and
+     * read_mapped reports the file as unreadable afterwards. Faults anywhere else get the previous handler.
+     */
+    thread_local uint8_t * mapped_begin = nullptr;
+    thread_local uint8_t * mapped_end = nullptr;
+    thread_local volatile sig_atomic_t mapped_truncated = 0;
+    uintptr_t sigbus_page_size = 0;
+    struct sigaction previous_sigbus { };
+
+    void on_sigbus(const int, siginfo_t * info, void *)
+    {
+        const int saved_errno = errno;
+        const auto address = static_cast<uint8_t *>(info->si_addr);
+        if (address >= mapped_begin && address < mapped_end)
+        {
+            uint8_t * page = address - reinterpret_cast<uintptr_t>(address) % sigbus_page_size;
+            if (mmap(page, static_cast<size_t>(mapped_end - page), PROT_READ,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) != MAP_FAILED)
+            {
+                mapped_truncated = 1;
+                errno = saved_errno;
+                return;
+            }
+        }
+
+        // not ours, the faulting access is repeated under the previous handler, a sent signal is sent again
+        sigaction(SIGBUS, &previous_sigbus, nullptr);
+        if (info->si_code <= 0) {
+            raise(SIGBUS);
+        }
+        errno = saved_errno;
+    }
+
+    void install_sigbus_handler()
+    {
+        static std::once_flag installed;
+        std::call_once(installed, []
+        {
+            sigbus_page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+            struct sigaction action { };
+            action.sa_sigaction = on_sigbus;
+            action.sa_flags = SA_SIGINFO;
+            sigemptyset(&action.sa_mask);
+            sigaction(SIGBUS, &action, &previous_sigbus);
+        });
+    }
+
+    bool read_mapped(const std::string & filename, const uint64_t offset, const uint64_t length,
+        const consumer_t & consumer)
+    {
+        if (length == 0) {
+            return false; // nothing to map, also how procfs-like files with no size look
+        }
+
+        const file_descriptor_t file(open(filename.c_str(), O_RDONLY | O_CLOEXEC));
+        if (file.fd < 0) {
+            return false;
+        }
+
+        install_sigbus_handler();
+        const auto page_size = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        uint64_t position = offset;
+        const uint64_t end = offset + length;
+        bool first_window = true;
+        while (position < end)
+        {
+            // mmap offsets have to be page aligned, start the window a bit earlier if needed
+            const uint64_t window_offset = position - position % page_size;
+            const uint64_t window_length = std::min<uint64_t>(map_window_size, end - window_offset);
+            void * window = mmap(nullptr, window_length, PROT_READ, MAP_PRIVATE, file.fd,
+                static_cast<off_t>(window_offset));
+            if (window == MAP_FAILED)
+            {
+                if (first_window) {
+                    return false;
+                }
+                throw std::runtime_error("Cannot map file: " + filename);
+            }
+
+            // hints only, failures are harmless
+            madvise(window, window_length, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+            madvise(window, window_length, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+
+            const uint64_t skip = position - window_offset;
+            stats::count_mapped(window_length - skip);
+            mapped_begin = static_cast<uint8_t *>(window);
+            mapped_end = mapped_begin + window_length;
+            try {
+                consumer(static_cast<const uint8_t *>(window) + skip, window_length - skip);
+            } catch (...) {
+                mapped_begin = mapped_end = nullptr;
+                mapped_truncated = 0;
+                munmap(window, window_length);
+                throw;
+            }
+
+            mapped_begin = mapped_end = nullptr;
+            munmap(window, window_length);
+            if (mapped_truncated) {
+                mapped_truncated = 0;
+                errno = EIO;
+                throw std::runtime_error("File was truncated while it was read: " + filename);
+            }
+            position = window_offset + window_length;
+            first_window = false;
+        }
+
+        return true;
+    }
+#else
+    bool read_mapped(const std::string &, uint64_t, uint64_t, const consumer_t &)
+    {
+        return false; // not implemented on this platform, callers read the file instead
+    }
+#endif // __unix__
+
+#ifdef __unix__
+    // grow a pipe towards size so that producers can run ahead of us, best effort
+    void enlarge_pipe([[maybe_unused]] const int fd, [[maybe_unused]] const size_t size)
+    {
+#ifdef F_SETPIPE_SZ
+        struct stat info { };
+        if (fstat(fd, &info) != 0 || !S_ISFIFO(info.st_mode)) {
+            return;
+        }
+
+        // unprivileged users are capped by /proc/sys/fs/pipe-max-size, 1M by default
+        if (fcntl(fd, F_SETPIPE_SZ, static_cast<int>(std::min<size_t>(size, 1 << 30))) < 0) {
+            fcntl(fd, F_SETPIPE_SZ, 1024 * 1024);
+        }
+#endif // F_SETPIPE_SZ
+    }
+
+    void write_all(const int fd, const uint8_t * data, size_t length)
+    {
+        while (length != 0)
+        {
+            const auto ret = write(fd, data, length);
+            if (ret < 0 && errno == EINTR) {
+                continue;
+            }
+            if (ret <= 0) {
+                throw std::runtime_error("Cannot write to output");
+            }
+            data += ret;
+            length -= static_cast<size_t>(ret);
+        }
+    }
+
+    uint64_t read_descriptor(const int fd, const consumer_t & consumer, const size_t block_size,
+        const int forward_fd)
+    {
+        enlarge_pipe(fd, block_size);
+        if (forward_fd >= 0) {
+            enlarge_pipe(forward_fd, block_size);
+        }
+
+        // duplicate pipe pages into the output pipe with tee(2), no copy through user space
+        bool use_tee = false;
+#ifdef SPLICE_F_NONBLOCK
+        use_tee = forward_fd >= 0;
+#endif // SPLICE_F_NONBLOCK
+
+        uint64_t total = 0;
+        bool exhausted = false;
+
+        // read exactly length bytes, false on a premature end of file
+        auto read_exactly = [&](uint8_t * buffer, size_t length)->size_t
+        {
+            size_t done = 0;
+            while (done < length)
+            {
+                const auto ret = read(fd, buffer + done, length - done);
+                stats::count_read_call();
+                if (ret < 0 && errno == EINTR) {
+                    continue;
+                }
+                if (ret < 0) {
+                    throw std::runtime_error("Cannot read STDIN");
+                }
+                if (ret == 0) {
+                    exhausted = true;
+                    break;
+                }
+                done += static_cast<size_t>(ret);
+            }
+            return done;
+        };
+
+        auto fill = [&](uint8_t * buffer)->size_t
+        {
+            size_t filled = 0;
+            while (!exhausted && filled < block_size)
+            {
+#ifdef SPLICE_F_NONBLOCK
+                if (use_tee)
+                {
+                    const auto teed = tee(fd, forward_fd, block_size - filled, 0);
+                    if (teed < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (teed < 0 && errno == EINVAL) {
+                        use_tee = false; // not two pipes, copy through the buffer instead
+                        continue;
+                    }
+                    if (teed < 0) {
+                        throw std::runtime_error("Cannot forward STDIN");
+                    }
+                    if (teed == 0) {
+                        exhausted = true;
+                        break;
+                    }
+                    // consume exactly what was duplicated, so both sides stay in step
+                    filled += read_exactly(buffer + filled, static_cast<size_t>(teed));
+                    continue;
+                }
+#endif // SPLICE_F_NONBLOCK
+
+                const size_t size = read_exactly(buffer + filled, block_size - filled);
+                if (forward_fd >= 0) {
+                    write_all(forward_fd, buffer + filled, size);
+                }
+                filled += size;
+            }
+
+            total += filled;
+            return filled;
+        };
+
+        read_blocks(fill, exhausted, consumer, block_size);
+        return total;
+    }
+#endif // __unix__
+
+#if defined(__unix__) && defined(SEEK_DATA) && defined(SEEK_HOLE)
+    bool for_each_extent(const std::string & filename, const uint64_t offset, const uint64_t length,
+        const extent_consumer_t & on_data, const hole_consumer_t & on_hole)
+    {
+        const file_descriptor_t file(open(filename.c_str(), O_RDONLY | O_CLOEXEC));
+        if (file.fd < 0) {
+            return false;
+        }
+
+        // fewer allocated blocks than the size needs is the cheap hint that there are holes at all
+        struct stat info { };
+        if (fstat(file.fd, &info) != 0 || static_cast<uint64_t>(info.st_blocks) * 512 >= static_cast<uint64_t>(info.st_size)) {
+            return false;
+        }
+
+        const uint64_t end = offset + length;
+        uint64_t position = offset;
+        bool first = true;
+        while (position < end)
+        {
+            auto data = static_cast<uint64_t>(lseek(file.fd, static_cast<off_t>(position), SEEK_DATA));
+            if (data == static_cast<uint64_t>(-1))
+            {
+                if (errno == ENXIO) {
+                    data = end; // nothing but a hole up to the end of the file
+                } else if (first) {
+                    return false; // e.g., EINVAL where SEEK_DATA is not supported
+                } else {
+                    throw std::runtime_error("Cannot seek in file: " + filename);
+                }
+            }
+            first = false;
+
+            data = std::min(data, end);
+            if (data > position) {
+                on_hole(data - position);
+            }
+            if (data == end) {
+                break;
+            }
+
+            auto hole = static_cast<uint64_t>(lseek(file.fd, static_cast<off_t>(data), SEEK_HOLE));
+            if (hole == static_cast<uint64_t>(-1)) {
+                throw std::runtime_error("Cannot seek in file: " + filename);
+            }
+            hole = std::min(hole, end);
+            on_data(data, hole - data);
+            position = hole;
+        }
+
+        return true;
+    }
+#else
+    bool for_each_extent(const std::string &, uint64_t, uint64_t, const extent_consumer_t &, const hole_consumer_t &)
+    {
+        return false; // no hole detection on this platform, the file is read densely
+    }
+#endif // __unix__ && SEEK_DATA && SEEK_HOLE
+
+#if defined(__unix__) && defined(O_DIRECT)
+    bool read_direct(const std::string & filename, const uint64_t offset, const uint64_t length,
+        const consumer_t & consumer, size_t block_size)
+    {
+        if (length == 0) {
+            return false;
+        }
+
+        const file_descriptor_t file(open(filename.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT));
+        if (file.fd < 0) {
+            return false; // e.g., tmpfs refuses O_DIRECT
+        }
+
+        // direct reads start on an aligned offset and cover whole aligned blocks, the tail of
+        // the file comes back as a short read; only [offset, end) is passed on
+        block_size = align_up(block_size);
+        const uint64_t end = offset + length;
+        uint64_t position = offset - offset % block_alignment;
+
+        // probe once, some filesystems only refuse unbuffered I/O at read time
+        {
+            uint8_t * probe = buffer_pool.acquire(block_alignment);
+            const auto ret = pread(file.fd, probe, block_alignment, static_cast<off_t>(position));
+            stats::count_read_call();
+            buffer_pool.release(probe, block_alignment);
+            if (ret < 0 && errno == EINVAL) {
+                return false;
+            }
+        }
+
+        run_pipeline(block_size, [&](uint8_t * buffer)->block_t
+        {
+            if (position >= end) {
+                return { };
+            }
+
+            const uint64_t wanted = std::min<uint64_t>(block_size, align_up(end - position));
+            ssize_t ret;
+            do {
+                ret = pread(file.fd, buffer, wanted, static_cast<off_t>(position));
+                stats::count_read_call();
+            } while (ret < 0 && errno == EINTR);
+
+            if (ret < 0 || position + static_cast<uint64_t>(ret) < std::min(end, position + wanted)) {
+                throw std::runtime_error("Cannot read file: " + filename);
+            }
+
+            const uint64_t skip = offset > position ? offset - position : 0;
+            const uint64_t useful = std::min<uint64_t>(end - position, static_cast<uint64_t>(ret)) - skip;
+            position += wanted;
+            return { .buffer = nullptr, .skip = skip, .length = useful };
+        }, consumer);
+
+        return true;
+    }
+#else
+    bool read_direct(const std::string &, uint64_t, uint64_t, const consumer_t &, size_t)
+    {
+        return false; // no O_DIRECT on this platform
+    }
+#endif // __unix__ && O_DIRECT
+
+#ifdef FILE_READER_IO_URING
+    // minimal io_uring wrapper over the raw syscalls, one per thread, reused across files
+    class uring_t {
+    private:
+        int ring_fd = -1;
+        void * sq_ring = MAP_FAILED;
+        size_t sq_ring_size = 0;
+        void * cq_ring = MAP_FAILED;
+        size_t cq_ring_size = 0;
+        void * sqe_area = MAP_FAILED;
+        size_t sqe_area_size = 0;
+
+        unsigned * sq_head = nullptr;
+        unsigned * sq_tail = nullptr;
+        unsigned * sq_mask = nullptr;
+        unsigned * sq_array = nullptr;
+        unsigned sq_entries = 0;
+        io_uring_sqe * sqes = nullptr;
+        unsigned * cq_head = nullptr;
+        unsigned * cq_tail = nullptr;
+        unsigned * cq_mask = nullptr;
+        io_uring_cqe * cqes = nullptr;
+
+        unsigned local_tail = 0;    // sqes prepared but not yet published
+        unsigned to_submit = 0;
+
+        void release()
+        {
+            if (sqe_area != MAP_FAILED) {
+                munmap(sqe_area, sqe_area_size);
+            }
+            if (cq_ring != MAP_FAILED && cq_ring != sq_ring) {
+                munmap(cq_ring, cq_ring_size);
+            }
+            if (sq_ring != MAP_FAILED) {
+                munmap(sq_ring, sq_ring_size);
+            }
+            if (ring_fd >= 0) {
+                close(ring_fd);
+            }
+        }
+
+        template < typename Type >
+        static Type * at(void * base, const unsigned offset) {
+            return reinterpret_cast<Type *>(static_cast<char *>(base) + offset);
+        }
+
+    public:
+        explicit uring_t(const unsigned entries)
+        {
+            io_uring_params params {};
+            ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (ring_fd < 0) {
+                throw std::runtime_error("io_uring_setup failed");
+            }
+
+            sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            if (params.features & IORING_FEAT_SINGLE_MMAP) {
+                sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+            }
+
+            sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                ring_fd, IORING_OFF_SQ_RING);
+            if (sq_ring != MAP_FAILED) {
+                cq_ring = (params.features & IORING_FEAT_SINGLE_MMAP) ? sq_ring
+                    : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd, IORING_OFF_CQ_RING);
+            }
+            if (cq_ring != MAP_FAILED) {
+                sqe_area_size = params.sq_entries * sizeof(io_uring_sqe);
+                sqe_area = mmap(nullptr, sqe_area_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd, IORING_OFF_SQES);
+            }
+            if (sqe_area == MAP_FAILED) {
+                release();
+                throw std::runtime_error("Cannot map io_uring rings");
+            }
+
+            sq_head = at<unsigned>(sq_ring, params.sq_off.head);
+            sq_tail = at<unsigned>(sq_ring, params.sq_off.tail);
+            sq_mask = at<unsigned>(sq_ring, params.sq_off.ring_mask);
+            sq_array = at<unsigned>(sq_ring, params.sq_off.array);
+            sq_entries = params.sq_entries;
+            sqes = static_cast<io_uring_sqe *>(sqe_area);
+            cq_head = at<unsigned>(cq_ring, params.cq_off.head);
+            cq_tail = at<unsigned>(cq_ring, params.cq_off.tail);
+            cq_mask = at<unsigned>(cq_ring, params.cq_off.ring_mask);
+            cqes = at<io_uring_cqe>(cq_ring, params.cq_off.cqes);
+            local_tail = *sq_tail;
+        }
+
+        ~uring_t() {
+            release();
+        }
+
+        uring_t(const uring_t &) = delete;
+        uring_t & operator=(const uring_t &) = delete;
+
+        [[nodiscard]] unsigned capacity() const {
+            return sq_entries;
+        }
+
+        void prepare_read(const int fd, void * buffer, const uint32_t length, const uint64_t offset,
+            const uint64_t user_data)
+        {
+            const unsigned index = local_tail & *sq_mask;
+            io_uring_sqe & sqe = sqes[index];
+            sqe = io_uring_sqe { };
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = fd;
+            sqe.addr = reinterpret_cast<uint64_t>(buffer);
+            sqe.len = length;
+            sqe.off = offset;
+            sqe.user_data = user_data;
+            sq_array[index] = index;
+            local_tail++;
+            to_submit++;
+        }
+
+        // publish prepared sqes, optionally wait for at least one completion
+        void submit(const bool wait)
+        {
+            std::atomic_ref<unsigned>(*sq_tail).store(local_tail, std::memory_order_release);
+            while (true)
+            {
+                const auto ret = syscall(__NR_io_uring_enter, ring_fd, to_submit, wait ? 1 : 0,
+                    wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+                stats::count_read_call();
+                if (ret >= 0) {
+                    to_submit -= static_cast<unsigned>(ret);
+                    return;
+                }
+                if (errno != EINTR) {
+                    throw std::runtime_error("io_uring_enter failed");
+                }
+            }
+        }
+
+        bool pop_completion(io_uring_cqe & cqe)
+        {
+            const unsigned head = *cq_head;
+            if (head == std::atomic_ref<unsigned>(*cq_tail).load(std::memory_order_acquire)) {
+                return false;
+            }
+
+            cqe = cqes[head & *cq_mask];
+            std::atomic_ref<unsigned>(*cq_head).store(head + 1, std::memory_order_release);
+            return true;
+        }
+    };
+
+    std::atomic < bool > uring_unavailable { false };
+
+    uring_t * thread_ring(const unsigned int queue_depth)
+    {
+        thread_local std::unique_ptr < uring_t > ring;
+        if (uring_unavailable) {
+            return nullptr; // given up on by any thread, rings built before do not keep trying
+        }
+
+        if (!ring)
+        {
+            try {
+                ring = std::make_unique < uring_t >(queue_depth);
+            } catch (const std::exception & e) {
+                uring_unavailable = true;
+                debug::log(debug::to_stderr, debug::warning_log, e.what(), ", falling back to regular reads\n");
+            }
+        }
+
+        return ring.get();
+    }
+
+    bool read_uring(const std::string & filename, const uint64_t offset, const uint64_t length,
+        const consumer_t & consumer, const unsigned int queue_depth, const size_t block_size)
+    {
+        uring_t * ring = length == 0 ? nullptr : thread_ring(queue_depth);
+        if (!ring) {
+            return false;
+        }
+
+        const file_descriptor_t file(open(filename.c_str(), O_RDONLY | O_CLOEXEC));
+        if (file.fd < 0) {
+            return false;
+        }
+
+        struct block_t {
+            int32_t result = 0;
+            bool done = false;
+        };
+
+        const uint64_t block_count = (length + block_size - 1) / block_size;
+        const auto depth = static_cast<unsigned>(std::min<uint64_t>({ ring->capacity(), queue_depth, block_count }));
+        // always taken at full depth, so every file and range reuses the same buffers from the pool
+        const size_t buffers_size = std::min<size_t>(ring->capacity(), queue_depth) * block_size;
+        uint8_t * buffers = buffer_pool.acquire(buffers_size);
+        std::vector < block_t > blocks(depth);
+
+        uint64_t submitted = 0;     // blocks handed to the kernel
+        uint64_t completed = 0;     // completions reaped
+        uint64_t consumed = 0;      // blocks passed to the consumer, always in order
+
+        auto block_offset = [&](const uint64_t block)->uint64_t { return offset + block * block_size; };
+        auto block_length = [&](const uint64_t block)->uint32_t {
+            return static_cast<uint32_t>(std::min<uint64_t>(block_size, length - block * block_size));
+        };
+        auto reap = [&]()->void {
+            io_uring_cqe cqe { };
+            while (ring->pop_completion(cqe)) {
+                auto & block = blocks[cqe.user_data % depth];
+                block.result = cqe.res;
+                block.done = true;
+                completed++;
+            }
+        };
+
+        try
+        {
+            while (consumed < block_count)
+            {
+                while (submitted < block_count && submitted - consumed < depth)
+                {
+                    blocks[submitted % depth] = block_t { };
+                    ring->prepare_read(file.fd, buffers + (submitted % depth) * block_size,
+                        block_length(submitted), block_offset(submitted), submitted);
+                    submitted++;
+                }
+
+                reap();
+                ring->submit(!blocks[consumed % depth].done);
+                reap();
+
+                while (consumed < submitted && blocks[consumed % depth].done)
+                {
+                    auto & block = blocks[consumed % depth];
+                    uint8_t * buffer = buffers + (consumed % depth) * block_size;
+                    const uint32_t expected = block_length(consumed);
+                    if (block.result == -EINVAL && consumed == 0) {
+                        // IORING_OP_READ needs Linux 5.6, older kernels reject it
+                        throw std::invalid_argument("IORING_OP_READ unsupported");
+                    }
+
+                    // short and interrupted reads are completed synchronously, they are rare on regular files
+                    uint32_t done = block.result > 0 ? static_cast<uint32_t>(block.result) : 0;
+                    if (block.result < 0 && block.result != -EINTR && block.result != -EAGAIN) {
+                        errno = -block.result;
+                        throw std::runtime_error("Cannot read file: " + filename);
+                    }
+                    while (done < expected)
+                    {
+                        const auto ret = pread(file.fd, buffer + done, expected - done,
+                            static_cast<off_t>(block_offset(consumed) + done));
+                        stats::count_read_call();
+                        if (ret < 0 && errno == EINTR) {
+                            continue;
+                        }
+                        if (ret <= 0) {
+                            throw std::runtime_error("Cannot read file: " + filename);
+                        }
+                        done += static_cast<uint32_t>(ret);
+                    }
+
+                    consumer(buffer, expected);
+                    consumed++;
+                }
+            }
+        }
+        catch (...)
+        {
+            // the kernel may still be writing into our buffers, wait for it before they go away
+            const int saved_errno = errno;
+            try {
+                while (completed < submitted) {
+                    ring->submit(true);
+                    reap();
+                }
+            } catch (...) {
+                buffers = nullptr; // better leaked than overwritten once reused
+            }
+            if (buffers) {
+                buffer_pool.release(buffers, buffers_size);
+            }
+            errno = saved_errno;
+
+            try {
+                throw;
+            } catch (const std::invalid_argument &) {
+                uring_unavailable = true;
+                debug::log(debug::to_stderr, debug::warning_log,
+                    "io_uring cannot read files on this kernel, falling back to regular reads\n");
+                return false;
+            }
+        }
+
+        buffer_pool.release(buffers, buffers_size);
+        return true;
+    }
+#else
+    bool read_uring(const std::string &, uint64_t, uint64_t, const consumer_t &, unsigned int, size_t)
+    {
+        return false; // no io_uring on this platform
+    }
+#endif // FILE_READER_IO_URING
+
+    bool read_regular_file(const options_t & options, const std::string & filename,
+        const uint64_t offset, const uint64_t length, const consumer_t & consumer)
+    {
+        switch (options.engine)
+        {
+            case MMAP:
+                return read_mapped(filename, offset, length, consumer);
+            case URING:
+                return read_uring(filename, offset, length, consumer, options.queue_depth, options.block_size);
+            case DIRECT:
+                return read_direct(filename, offset, length, consumer, options.block_size);
+            case STREAM:
+            default:
+                return false;
+        }
+    }
+} // file_reader
@@ -21,16 +21,61 @@
 #ifndef BIN2HEX_H
 #define BIN2HEX_H
 
-#include <vector>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
 #include <string>
+#include <vector>
 
 namespace bin2hex {
-    void c_bin2hex(char bin, char hex[2]);
+    // hex digits per line of the wrapped output of bin2hex(), 0 for a single line
+    constexpr size_t max_line_char_num = 64;
+
+    // the two lowercase hex digits of every byte value
+    inline constexpr auto hex_pairs = [] {
+        constexpr char digits[] = "0123456789abcdef";
+        std::array < std::array < char, 2 >, 256 > table { };
+        for (size_t i = 0; i < table.size(); ++i) {
+            table[i] = { digits[i >> 4], digits[i & 0x0F] };
+        }
+        return table;
+    }();
+
+    inline void c_bin2hex(const char bin, char hex[2])
+    {
+        const auto & pair = hex_pairs[static_cast<uint8_t>(bin)];
+        hex[0] = pair[0];
+        hex[1] = pair[1];
+    }
+
+    // write 2 * bin.size() hex digits to out, one table lookup per byte
+    template < std::output_iterator < char > OutputIt >
+    OutputIt encode(const std::span < const uint8_t > bin, OutputIt out)
+    {
+        for (const uint8_t byte : bin) {
+            *out++ = hex_pairs[byte][0];
+            *out++ = hex_pairs[byte][1];
+        }
+        return out;
+    }
+
+    /*
+     * Write the hex digits of bin into out, which needs room for 2 * bin.size() of them.
+     * Large buffers go through SSSE3 or NEON where available. Returns the number of digits written.
+     */
+    size_t encode(std::span < const uint8_t > bin, std::span < char > out);
+
+    // hex digits with a line break after every line_length of them, none when line_length is 0
+    std::string bin2hex(std::span < const uint8_t > bin, size_t line_length);
+
+    inline std::string bin2hex(const std::vector < char > & vec) {
+        return bin2hex::bin2hex(std::span(reinterpret_cast<const uint8_t *>(vec.data()), vec.size()), max_line_char_num);
+    }
 
-    std::string bin2hex(const std::vector < char > &);
     inline std::string bin2hex(const std::string & str) {
-        const std::vector < char > vec(str.begin(), str.end());
-        return bin2hex::bin2hex(vec);
+        return bin2hex::bin2hex(std::span(reinterpret_cast<const uint8_t *>(str.data()), str.size()), max_line_char_num);
     }
 } // bin2hex
 
@@ -0,0 +1,104 @@
+/* checksum_cache.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef CHECKSUM_CACHE_H
+#define CHECKSUM_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Checksums computed on earlier runs, kept in a hash table file that is memory mapped and shared
+ * by every crc64sum process pointing at it. Entries are found by (device, inode, CRC-64 variant)
+ * and only served while the file size and modification time are unchanged. Lookups take no lock,
+ * a sequence counter in each slot catches entries that are being rewritten at the same time,
+ * stores are serialized with flock(2) across processes. When every slot a file may go to is taken,
+ * the table is copied into a file twice the size that is renamed into place, other processes
+ * move over to it on their next store.
+ */
+class ChecksumCache {
+public:
+    // identity and state of a file, as reported by stat(2)
+    struct file_key_t {
+        uint64_t device;
+        uint64_t inode;
+        uint64_t size;
+        int64_t mtime_ns;
+
+        bool operator==(const file_key_t &) const = default;
+    };
+
+private:
+    struct slot_t;
+
+    // one mapping of the cache file
+    struct table_t {
+        int fd = -1;
+        void * map = nullptr;
+        size_t map_size = 0;
+        slot_t * slots = nullptr;
+        uint64_t slot_count = 0;
+    };
+
+    std::string path;
+    uint64_t algorithm;
+    std::atomic < table_t * > table { nullptr };            // the one in use, replaced when it grows
+    std::vector < std::unique_ptr < table_t > > tables;     // all mapped so far, lookups may still be in old ones
+    std::mutex store_mutex; // flock(2) locks belong to the open file, threads of this process queue here
+    std::atomic < uint64_t > hit_count { 0 };
+    std::atomic < uint64_t > miss_count { 0 };
+    std::atomic < uint64_t > eviction_count { 0 };
+
+    [[nodiscard]] static slot_t * find_slot(const table_t & table, const file_key_t & key, uint64_t algorithm);
+    [[nodiscard]] std::unique_ptr < table_t > open_table() const;
+    [[nodiscard]] std::unique_ptr < table_t > grow(const table_t & full) const;
+    void use_table(std::unique_ptr < table_t > next);
+
+public:
+    // opens the cache file at path, creating it if it does not exist, throws if it is not a cache;
+    // algorithm is the CRC64::algorithm_id() of the checksums looked up and stored
+    explicit ChecksumCache(const std::string & path, uint64_t algorithm = 0);
+    ~ChecksumCache();
+
+    ChecksumCache(const ChecksumCache &) = delete;
+    ChecksumCache & operator=(const ChecksumCache &) = delete;
+
+    // key of a regular file, false for anything else
+    static bool file_key(const std::string & filename, file_key_t & key);
+
+    // checksums are stored in little endian byte order, i.e., CRC64::get_checksum(LITTLE_ENDIAN)
+    bool lookup(const file_key_t & key, uint64_t & checksum);
+    void store(const file_key_t & key, uint64_t checksum);
+
+    // a file that was hashed without asking the cache first, e.g., when re-hashing is forced
+    void count_miss() { ++miss_count; }
+
+    [[nodiscard]] uint64_t hits() const { return hit_count; }
+    [[nodiscard]] uint64_t misses() const { return miss_count; }
+    // entries overwritten by others once the table could not grow any further
+    [[nodiscard]] uint64_t evictions() const { return eviction_count; }
+};
+
+#endif //CHECKSUM_CACHE_H
@@ -0,0 +1,51 @@
+/* checksum_xattr.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef CHECKSUM_XATTR_H
+#define CHECKSUM_XATTR_H
+
+#include "checksum_cache.h"
+#include <cstdint>
+#include <string>
+
+/*
+ * Checksums kept with the file itself in the user.crc64 extended attribute, together with the
+ * size and modification time they were computed for. The attribute follows the file through
+ * cp --preserve=xattr or rsync -X, so only size and mtime are compared, not device and inode.
+ * Variants other than CRC-64/XZ use their own attribute, e.g., user.crc64.nvme.
+ */
+namespace checksum_xattr {
+    enum mode_t {
+        IGNORE,     // neither read nor write attributes
+        TRUST,      // serve checksums from attributes that still match the file
+        POPULATE,   // write the checksum of every file hashed
+    };
+
+    // parse a mode given on the command line, throws on unknown names
+    mode_t mode_from_name(const std::string & name);
+
+    // checksum in little endian byte order, false if there is none or the file changed since
+    bool load(const std::string & filename, const ChecksumCache::file_key_t & key, uint64_t & checksum);
+
+    // false if the file system or the permissions do not allow it
+    bool store(const std::string & filename, const ChecksumCache::file_key_t & key, uint64_t checksum);
+}
+
+#endif //CHECKSUM_XATTR_H
@@ -0,0 +1,123 @@
+/* crc64.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef CRC64_H
+#define CRC64_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#ifdef __unix__
+# include <sys/types.h> // pull in the libc endian macros before dropping them
+# undef LITTLE_ENDIAN
+# undef BIG_ENDIAN
+#endif // __unix__
+
+enum endian_t { LITTLE_ENDIAN, BIG_ENDIAN };
+
+class CRC64 {
+public:
+    // raw kernel, advances a (non-complemented) CRC register over length bytes
+    using kernel_t = uint64_t (*)(uint64_t crc, const uint8_t * data, size_t length);
+
+    struct kernel_entry_t {
+        const char * name;
+        kernel_t kernel;
+    };
+
+    // a CRC-64 variant, see crc64_engine.h for the parameters
+    struct algorithm_t {
+        const char * name;
+        kernel_t kernel;
+        uint64_t (*shift)(uint64_t crc, uint64_t count);    // advance a register over count zero bytes
+        uint64_t init;
+        uint64_t xor_out;
+    };
+
+    CRC64() : crc64_value(algorithm->init) { }
+
+    // carry on from a checksum returned by get_checksum(LITTLE_ENDIAN)
+    explicit CRC64(const uint64_t checksum) : crc64_value(checksum ^ algorithm->xor_out) { }
+
+    void update(const uint8_t* data, const size_t length) {
+        crc64_value = algorithm->kernel(crc64_value, data, length);
+    }
+
+    // same as update() over count zero bytes, without touching any memory
+    void update_zeros(const uint64_t count) {
+        crc64_value = algorithm->shift(crc64_value, count);
+    }
+
+    [[nodiscard]] uint64_t get_checksum(const endian_t endian = BIG_ENDIAN
+        /* CRC64 tools like 7ZIP display in BIG_ENDIAN */) const
+    {
+        // add the final complement that CRC-64/XZ requires
+        return (endian == BIG_ENDIAN
+            ? reverse_bytes(crc64_value ^ algorithm->xor_out)
+            : (crc64_value ^ algorithm->xor_out));
+    }
+
+    // append a CRC64 computed separately over the next next_length bytes of the same stream
+    void combine(const CRC64 & next, const uint64_t next_length) {
+        // next started from init rather than from this register, only the difference needs shifting
+        crc64_value = algorithm->shift(crc64_value ^ algorithm->init, next_length) ^ next.crc64_value;
+    }
+
+    // checksum of A|B from the checksums of A and B (as returned by get_checksum(LITTLE_ENDIAN)) and length of B
+    [[nodiscard]] static uint64_t combine(uint64_t crc_a, uint64_t crc_b, uint64_t length_b);
+
+    /*
+     * Switch every CRC64 object to another variant, i.e., "xz" (the default), "ecma-182", "go-iso"
+     * or "nvme". Must be called before anything is hashed, throws on unknown names.
+     */
+    static void use_algorithm(const std::string & name);
+
+    // names accepted by use_algorithm(), comma separated
+    [[nodiscard]] static std::string algorithm_names();
+
+    [[nodiscard]] static const char * algorithm_name() {
+        return algorithm->name;
+    }
+
+    // 0 for CRC-64/XZ, new variants are only ever appended, so this can be stored on disk
+    [[nodiscard]] static unsigned int algorithm_id();
+
+    // name of the kernel in use, i.e., "table", "pclmul", "vpclmul" or "pmull"
+    [[nodiscard]] static const char * kernel_name();
+
+    // every CRC-64/XZ kernel this CPU can run, fastest first, regardless of CRC64_KERNEL
+    [[nodiscard]] static std::vector < kernel_entry_t > available_kernels();
+
+    static uint64_t reverse_bytes(uint64_t x)
+    {
+        x = ((x & 0x00000000FFFFFFFFULL) << 32) | ((x & 0xFFFFFFFF00000000ULL) >> 32);
+        x = ((x & 0x0000FFFF0000FFFFULL) << 16) | ((x & 0xFFFF0000FFFF0000ULL) >> 16);
+        x = ((x & 0x00FF00FF00FF00FFULL) << 8)  | ((x & 0xFF00FF00FF00FF00ULL) >> 8);
+        return x;
+    }
+
+private:
+    uint64_t crc64_value;
+    static const algorithm_t * algorithm;
+};
+
+#endif //CRC64_H
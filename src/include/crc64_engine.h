@@ -0,0 +1,202 @@
+/* crc64_engine.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef CRC64_ENGINE_H
+#define CRC64_ENGINE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Table driven CRC-64 for any polynomial, with the parameters of the Rocksoft model.
+ * Poly is given in normal (MSB first) form; Reflected selects LSB first processing, as used by
+ * CRC-64/XZ and most others. The slice-by-8 tables and the x^(2^k) powers for combining are
+ * computed at compile time and shared by every instance, which holds nothing but the register.
+ */
+template < uint64_t Poly, bool Reflected, uint64_t Init, uint64_t XorOut >
+class CRC64Engine {
+public:
+    using table_t = std::array < std::array < uint64_t, 256 >, 8 >;
+
+    static constexpr uint64_t init = Init;
+    static constexpr uint64_t xor_out = XorOut;
+
+private:
+    static constexpr uint64_t reflect(uint64_t x)
+    {
+        uint64_t result = 0;
+        for (int i = 0; i < 64; ++i, x >>= 1) {
+            result = (result << 1) | (x & 1);
+        }
+        return result;
+    }
+
+    // register representation of the polynomial, x^0 and x^1
+    static constexpr uint64_t poly = Reflected ? reflect(Poly) : Poly;
+    static constexpr uint64_t one = Reflected ? 1ULL << 63 : 1;
+    static constexpr uint64_t x = Reflected ? 1ULL << 62 : 2;
+
+    // b * x mod P
+    static constexpr uint64_t times_x(const uint64_t b)
+    {
+        if constexpr (Reflected) {
+            return (b & 1) ? (b >> 1) ^ poly : (b >> 1);
+        } else {
+            return (b >> 63) ? (b << 1) ^ poly : (b << 1);
+        }
+    }
+
+    static constexpr table_t make_tables()
+    {
+        table_t result {};
+        for (uint64_t i = 0; i < 256; ++i)
+        {
+            uint64_t crc = Reflected ? i : i << 56;
+            for (int j = 0; j < 8; ++j) {
+                crc = times_x(crc);
+            }
+            result[0][i] = crc;
+        }
+
+        // table[k] advances table[0] by k more zero bytes
+        for (uint64_t i = 0; i < 256; ++i) {
+            for (size_t k = 1; k < result.size(); ++k) {
+                const uint64_t prev = result[k - 1][i];
+                result[k][i] = Reflected
+                    ? result[0][prev & 0xFF] ^ (prev >> 8)
+                    : result[0][prev >> 56] ^ (prev << 8);
+            }
+        }
+
+        return result;
+    }
+
+    static constexpr std::array < uint64_t, 64 > make_x_2_powers()
+    {
+        std::array < uint64_t, 64 > result {};
+        result[0] = x;
+        for (size_t i = 1; i < result.size(); ++i) {
+            result[i] = multiply(result[i - 1], result[i - 1]);
+        }
+        return result;
+    }
+
+public:
+    static constexpr table_t tables = make_tables();
+
+    // a * b mod P, both in register representation
+    static constexpr uint64_t multiply(const uint64_t a, uint64_t b)
+    {
+        uint64_t product = 0;
+        for (uint64_t mask = one; mask != 0; mask = Reflected ? mask >> 1 : mask << 1)
+        {
+            if (a & mask) {
+                product ^= b;
+            }
+            b = times_x(b);
+        }
+        return product;
+    }
+
+    // x^(2^k) mod P
+    static constexpr std::array < uint64_t, 64 > x_2_powers = make_x_2_powers();
+
+    // advance a raw register over length bytes
+    static constexpr uint64_t update(uint64_t crc, const uint8_t * data, size_t length)
+    {
+        const auto & table = tables;
+        while (length >= 8)
+        {
+            uint64_t word = 0;
+            for (int i = 0; i < 8; ++i) {
+                word |= static_cast<uint64_t>(data[i]) << (Reflected ? 8 * i : 56 - 8 * i);
+            }
+            word ^= crc;
+
+            if constexpr (Reflected) {
+                crc = table[7][word & 0xFF]         ^ table[6][(word >> 8) & 0xFF]
+                    ^ table[5][(word >> 16) & 0xFF] ^ table[4][(word >> 24) & 0xFF]
+                    ^ table[3][(word >> 32) & 0xFF] ^ table[2][(word >> 40) & 0xFF]
+                    ^ table[1][(word >> 48) & 0xFF] ^ table[0][word >> 56];
+            } else {
+                crc = table[7][word >> 56]          ^ table[6][(word >> 48) & 0xFF]
+                    ^ table[5][(word >> 40) & 0xFF] ^ table[4][(word >> 32) & 0xFF]
+                    ^ table[3][(word >> 24) & 0xFF] ^ table[2][(word >> 16) & 0xFF]
+                    ^ table[1][(word >> 8) & 0xFF]  ^ table[0][word & 0xFF];
+            }
+            data += 8;
+            length -= 8;
+        }
+
+        while (length--)
+        {
+            if constexpr (Reflected) {
+                crc = table[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+            } else {
+                crc = table[0][(crc >> 56) ^ *data++] ^ (crc << 8);
+            }
+        }
+
+        return crc;
+    }
+
+    // advance a raw register over count zero bytes, i.e., multiply it by x^(8 * count)
+    static constexpr uint64_t shift(uint64_t crc, uint64_t count)
+    {
+        for (unsigned int k = 3; count != 0; count >>= 1, ++k) {
+            if (count & 1) {
+                crc = multiply(x_2_powers[k & 63], crc);
+            }
+        }
+        return crc;
+    }
+
+    // checksum of A|B from the checksums of A and B and the length of B
+    static constexpr uint64_t combine(const uint64_t crc_a, const uint64_t crc_b, const uint64_t length_b) {
+        return shift(crc_a ^ XorOut ^ Init, length_b) ^ crc_b;
+    }
+
+    // checksum of a whole buffer
+    static constexpr uint64_t checksum(const uint8_t * data, const size_t length) {
+        return update(Init, data, length) ^ XorOut;
+    }
+
+    void update(const uint8_t * data, const size_t length) {
+        state = update(state, data, length);
+    }
+
+    [[nodiscard]] constexpr uint64_t get_checksum() const {
+        return state ^ XorOut;
+    }
+
+private:
+    uint64_t state = Init;
+};
+
+// the variants in common use, named as in the CRC RevEng catalogue
+using crc64_ecma_182_t = CRC64Engine < 0x42F0E1EBA9EA3693ULL, false, 0, 0 >;
+using crc64_xz_t       = CRC64Engine < 0x42F0E1EBA9EA3693ULL, true, ~0ULL, ~0ULL >;
+using crc64_go_iso_t   = CRC64Engine < 0x000000000000001BULL, true, ~0ULL, ~0ULL >;
+using crc64_nvme_t     = CRC64Engine < 0xAD93D23594C93659ULL, true, ~0ULL, ~0ULL >;
+
+static_assert(sizeof(crc64_xz_t) == sizeof(uint64_t));
+
+#endif //CRC64_ENGINE_H
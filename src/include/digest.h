@@ -0,0 +1,96 @@
+/* digest.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef DIGEST_H
+#define DIGEST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Digests computed next to CRC64 with --digest, over the same reads, so that files needed
+ * by several consumers (7-Zip, object stores, deduplication) are read only once.
+ */
+namespace digest {
+    enum kind_t {
+        CRC32C_DIGEST,  // Castagnoli CRC-32 as used by iSCSI, ext4 and most object stores
+        XXH64_DIGEST,   // xxHash64 with seed 0
+    };
+
+    // parse a digest name given on the command line, throws on unknown names
+    kind_t kind_from_name(const std::string & name);
+
+    // number of hex digits printed for a digest
+    size_t hex_width(kind_t kind);
+
+    // CRC-32C with SSE4.2 or the ARMv8 CRC instructions when the CPU has them, slice-by-8 otherwise
+    class CRC32C {
+    private:
+        uint32_t crc32c_value = 0xFFFFFFFF;
+
+    public:
+        void update(const uint8_t * data, size_t length);
+
+        [[nodiscard]] uint32_t get_checksum() const {
+            return crc32c_value ^ 0xFFFFFFFF;
+        }
+    };
+
+    class XXH64 {
+    private:
+        uint64_t lanes[4];
+        uint8_t pending[32] { };    // input not yet consumed by a full stripe
+        size_t pending_length = 0;
+        uint64_t total_length = 0;
+
+        void consume(const uint8_t * stripe);
+
+    public:
+        XXH64();
+        void update(const uint8_t * data, size_t length);
+        [[nodiscard]] uint64_t get_checksum() const;
+    };
+
+    // the digests asked for besides CRC64, all fed with the same buffers
+    class Extras {
+    private:
+        std::vector < kind_t > kinds;
+        CRC32C crc32c;
+        XXH64 xxh64;
+        bool want_crc32c = false;
+        bool want_xxh64 = false;
+
+    public:
+        explicit Extras(const std::vector < kind_t > & kinds_);
+
+        [[nodiscard]] bool empty() const {
+            return kinds.empty();
+        }
+
+        void update(const uint8_t * data, size_t length);
+
+        // digest values in the order the kinds were given, as numbers, i.e., printed most significant digit first
+        [[nodiscard]] std::vector < uint64_t > values() const;
+    };
+}
+
+#endif //DIGEST_H
@@ -0,0 +1,42 @@
+/* directory_walker.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef DIRECTORY_WALKER_H
+#define DIRECTORY_WALKER_H
+
+#include <string>
+#include <vector>
+
+namespace directory_walker {
+    struct options_t {
+        bool follow_symlinks = false;   // otherwise symbolic links below the root are skipped
+        bool one_file_system = false;   // do not descend into directories on other file systems
+        unsigned int threads = 1;       // 0 means one per hardware thread
+    };
+
+    /*
+     * Regular files below root, sorted by path. Directories are read with getdents64 on a set of
+     * threads that each work through their own queue of directories and steal from the others when
+     * it runs dry. Directories that cannot be read are reported as warnings and skipped.
+     */
+    std::vector < std::string > list_files(const std::string & root, const options_t & options);
+}
+
+#endif //DIRECTORY_WALKER_H
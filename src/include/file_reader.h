@@ -0,0 +1,112 @@
+/* file_reader.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef FILE_READER_H
+#define FILE_READER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <limits>
+#include <string>
+
+namespace file_reader {
+    enum engine_t { STREAM, MMAP, URING, DIRECT };
+
+    struct options_t {
+#ifdef __unix__
+        engine_t engine = MMAP;
+#else
+        engine_t engine = STREAM;
+#endif // __unix__
+        unsigned int queue_depth = 32;          // reads kept in flight by the io_uring engine
+        size_t block_size = 1024 * 1024;        // size of each of these reads
+    };
+
+    // receives the file content in order, one chunk at a time
+    using consumer_t = std::function < void(const uint8_t * data, size_t length) >;
+    // receives an allocated extent of a sparse file, or the length of a hole
+    using extent_consumer_t = std::function < void(uint64_t offset, uint64_t length) >;
+    using hole_consumer_t = std::function < void(uint64_t length) >;
+
+    // parse an engine name given on the command line, throws on unknown names
+    engine_t engine_from_name(const std::string & name);
+
+    // size of a regular file, false for anything else
+    bool regular_file_size(const std::string & filename, uint64_t & size);
+
+    /*
+     * Feed length bytes starting at offset straight from the page cache.
+     * Returns false without consuming anything if the file cannot be mapped,
+     * in which case the caller should fall back to reading it. A file truncated while it is
+     * mapped is reported as a read error instead of taking the process down with SIGBUS.
+     */
+    bool read_mapped(const std::string & filename, uint64_t offset, uint64_t length, const consumer_t & consumer);
+
+    /*
+     * Keep up to queue_depth reads of block_size bytes in flight with io_uring and feed the
+     * completed blocks in file order. Returns false without consuming anything if io_uring
+     * is not available on this kernel.
+     */
+    bool read_uring(const std::string & filename, uint64_t offset, uint64_t length, const consumer_t & consumer,
+        unsigned int queue_depth, size_t block_size);
+
+    /*
+     * Read with O_DIRECT, bypassing the page cache, into aligned blocks taken from a pool that is
+     * reused across files. A reader thread fills the next blocks while the current one is consumed.
+     * Returns false without consuming anything if the file system refuses unbuffered I/O.
+     */
+    bool read_direct(const std::string & filename, uint64_t offset, uint64_t length, const consumer_t & consumer,
+        size_t block_size);
+
+    /*
+     * Read up to limit bytes from a stream in blocks of block_size. A reader thread fills the next
+     * block while the current one is consumed, inputs that fit in one block are read inline.
+     * Returns the number of bytes consumed, check stream.bad() for read errors.
+     */
+    uint64_t read_stream(std::istream & stream, const consumer_t & consumer, size_t block_size,
+        uint64_t limit = std::numeric_limits < uint64_t >::max());
+
+#ifdef __unix__
+    /*
+     * Read a file descriptor, i.e., STDIN, with plain read(2) in blocks of block_size, pipes are
+     * enlarged to match first. With forward_fd >= 0, everything read is also copied there unchanged,
+     * through tee(2) without passing the data through user space when both ends are pipes.
+     * Returns the number of bytes consumed.
+     */
+    uint64_t read_descriptor(int fd, const consumer_t & consumer, size_t block_size, int forward_fd = -1);
+#endif // __unix__
+
+    /*
+     * Walk [offset, offset + length) of a sparse regular file with SEEK_DATA/SEEK_HOLE and call
+     * on_data for every allocated extent and on_hole for every hole, in file order.
+     * Returns false without calling either if the file has no holes or the file system cannot tell.
+     */
+    bool for_each_extent(const std::string & filename, uint64_t offset, uint64_t length,
+        const extent_consumer_t & on_data, const hole_consumer_t & on_hole);
+
+    // read a range of a regular file with the engine in options,
+    // false means the engine cannot handle it and the caller should stream the file instead
+    bool read_regular_file(const options_t & options, const std::string & filename,
+        uint64_t offset, uint64_t length, const consumer_t & consumer);
+} // file_reader
+
+#endif //FILE_READER_H
@@ -0,0 +1,68 @@
+/* libcrc64.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef LIBCRC64_H
+#define LIBCRC64_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+# if defined(CRC64_BUILDING_LIBRARY)
+#  define CRC64_API __declspec(dllexport)
+# else
+#  define CRC64_API
+# endif
+#else
+# define CRC64_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * CRC-64/XZ (the checksum crc64sum prints) over a stream fed in pieces, with the fastest
+ * kernel the CPU supports. Checksums are plain numbers, e.g., 0x995DC9BBDF1939FA for "123456789",
+ * which crc64sum prints as fa3919dfbbc95d99 with --endian little and 995dc9bbdf1939fa by default.
+ */
+typedef struct crc64_state {
+    uint64_t checksum;  /* checksum of everything fed so far */
+} crc64_state_t;
+
+CRC64_API void crc64_init(crc64_state_t * state);
+CRC64_API void crc64_update(crc64_state_t * state, const void * data, size_t length);
+
+/* same as crc64_update() over count zero bytes, in O(log count) without touching memory */
+CRC64_API void crc64_update_zeros(crc64_state_t * state, uint64_t count);
+
+CRC64_API uint64_t crc64_final(const crc64_state_t * state);
+
+/* checksum of A followed by B, from the checksums of A and B and the length of B */
+CRC64_API uint64_t crc64_combine(uint64_t checksum_a, uint64_t checksum_b, uint64_t length_b);
+
+/* kernel picked at load time, i.e., "table", "pclmul", "vpclmul" or "pmull" */
+CRC64_API const char * crc64_kernel_name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LIBCRC64_H */
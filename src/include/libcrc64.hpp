@@ -0,0 +1,87 @@
+/* libcrc64.hpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef LIBCRC64_HPP
+#define LIBCRC64_HPP
+
+#include "libcrc64.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// header-only C++ wrapper around the C ABI of libcrc64
+namespace crc64 {
+    class Stream {
+    private:
+        crc64_state_t state { };
+
+    public:
+        Stream() noexcept {
+            crc64_init(&state);
+        }
+
+        Stream & update(const void * data, const size_t length) noexcept {
+            crc64_update(&state, data, length);
+            return *this;
+        }
+
+        Stream & update(const std::span < const std::byte > data) noexcept {
+            return update(data.data(), data.size());
+        }
+
+        Stream & update(const std::string_view data) noexcept {
+            return update(data.data(), data.size());
+        }
+
+        Stream & update_zeros(const uint64_t count) noexcept {
+            crc64_update_zeros(&state, count);
+            return *this;
+        }
+
+        // append a stream hashed separately, e.g., the next range of a file hashed on another thread
+        Stream & combine(const Stream & next, const uint64_t next_length) noexcept {
+            state.checksum = crc64_combine(state.checksum, next.checksum(), next_length);
+            return *this;
+        }
+
+        void reset() noexcept {
+            crc64_init(&state);
+        }
+
+        [[nodiscard]] uint64_t checksum() const noexcept {
+            return crc64_final(&state);
+        }
+
+        [[nodiscard]] static const char * kernel_name() noexcept {
+            return crc64_kernel_name();
+        }
+    };
+
+    inline uint64_t checksum(const void * data, const size_t length) noexcept {
+        return Stream().update(data, length).checksum();
+    }
+
+    inline uint64_t checksum(const std::string_view data) noexcept {
+        return Stream().update(data).checksum();
+    }
+}
+
+#endif //LIBCRC64_HPP
@@ -0,0 +1,167 @@
+/* manifest.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef MANIFEST_H
+#define MANIFEST_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace manifest {
+    // one <FILENAME>: <CHECKSUM> line, filename points into the manifest
+    struct entry_t {
+        std::string_view filename;
+        uint64_t checksum = 0;      // the value hash_a_file returns for the printed hex
+        bool well_formed = false;   // 16 hex digits, anything else never matches
+    };
+
+    // hex digits as printed by crc64sum, spaces and non-printable characters around them are ignored,
+    // as are the --digest values that may follow
+    bool parse_checksum(std::string_view text, uint64_t & checksum);
+
+    // a checksum file mapped into memory, read into a buffer where it cannot be mapped
+    class TextManifest {
+    private:
+        const char * data = nullptr;
+        size_t size = 0;
+        void * map = nullptr;
+        std::string buffer;
+
+    public:
+        // throws if the file cannot be read
+        explicit TextManifest(const std::string & filename);
+        ~TextManifest();
+
+        TextManifest(const TextManifest &) = delete;
+        TextManifest & operator=(const TextManifest &) = delete;
+
+        /*
+         * Calls on_entry(const entry_t &) for every line in file order, or on_invalid() for lines without
+         * a filename. Entries point into this manifest and stay valid for as long as it lives.
+         */
+        template < typename OnEntry, typename OnInvalid >
+        void for_each(OnEntry && on_entry, OnInvalid && on_invalid) const
+        {
+            const char * line = data;
+            const char * const end = data + size;
+            while (line != end)
+            {
+                const auto * newline = static_cast<const char *>(std::memchr(line, '\n', end - line));
+                const char * line_end = newline ? newline : end;
+
+                // the last ':' separates the checksum, filenames may have their own
+                const char * colon = line_end;
+                while (colon != line && *(colon - 1) != ':') {
+                    --colon;
+                }
+
+                if (colon == line || colon - 1 == line) {
+                    on_invalid();
+                } else {
+                    entry_t entry;
+                    entry.filename = std::string_view(line, colon - 1 - line);
+                    entry.well_formed = parse_checksum(std::string_view(colon, line_end - colon), entry.checksum);
+                    on_entry(entry);
+                }
+
+                line = newline ? newline + 1 : end;
+            }
+        }
+    };
+
+    // one file of a binary manifest
+    struct record_t {
+        std::string filename;
+        uint64_t size = 0;          // 0 when unknown, e.g., imported from a checksum file
+        int64_t mtime_ns = 0;
+        uint64_t checksum = 0;      // in little endian byte order, i.e., CRC64::get_checksum(LITTLE_ENDIAN)
+    };
+
+    // write records sorted by filename, through a temporary file renamed into place
+    void write_binary(const std::string & filename, std::vector < record_t > records);
+
+    // true if the file starts like a binary manifest
+    bool is_binary(const std::string & filename);
+
+    /*
+     * A binary manifest mapped into memory: a header, fixed size records sorted by filename and an
+     * arena holding the filenames. Files are found by binary search over the records, so verifying a
+     * few of them does not read the rest. All numbers are stored in little endian byte order.
+     */
+    class BinaryManifest {
+    public:
+        struct header_t {
+            char magic[8];
+            uint32_t version;
+            uint32_t record_size;
+            uint64_t record_count;
+            uint64_t records_offset;
+            uint64_t arena_offset;
+            uint64_t arena_size;
+        };
+
+        struct disk_record_t {
+            uint64_t filename_offset;   // into the arena
+            uint64_t filename_length;
+            uint64_t size;
+            uint64_t mtime_ns;
+            uint64_t checksum;
+        };
+
+    private:
+        const uint8_t * data = nullptr;
+        size_t size = 0;
+        void * map = nullptr;
+        std::string buffer;
+        const disk_record_t * records = nullptr;
+        uint64_t record_count = 0;
+        const char * arena = nullptr;
+        uint64_t arena_size = 0;
+        std::string name;
+
+    public:
+        // throws if the file cannot be read or is not a binary manifest
+        explicit BinaryManifest(const std::string & filename);
+        ~BinaryManifest();
+
+        BinaryManifest(const BinaryManifest &) = delete;
+        BinaryManifest & operator=(const BinaryManifest &) = delete;
+
+        [[nodiscard]] uint64_t count() const { return record_count; }
+
+        // filename points into this manifest and throws if it does not, checksum is in little endian byte order
+        [[nodiscard]] std::string_view filename(uint64_t index) const;
+        [[nodiscard]] uint64_t checksum(uint64_t index) const;
+        [[nodiscard]] uint64_t file_size(uint64_t index) const;
+        [[nodiscard]] int64_t mtime_ns(uint64_t index) const;
+
+        // index of the first record not sorting before filename, count() if there is none
+        [[nodiscard]] uint64_t lower_bound(std::string_view filename) const;
+
+        // records whose filename equals path, or starts with it when it ends with a '/'
+        [[nodiscard]] std::pair < uint64_t, uint64_t > select(std::string_view path) const;
+    };
+}
+
+#endif //MANIFEST_H
@@ -0,0 +1,69 @@
+/* output_writer.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/*
+ * Result lines collected in one large buffer and handed to the stream in big chunks, instead of
+ * a flush per line. Lines are appended whole under a lock, so they never interleave when several
+ * threads report. Interactive output asks for a flush after every line instead.
+ */
+class OutputWriter {
+private:
+    static constexpr size_t flush_threshold = 256 * 1024;
+
+    std::ostream & stream;
+    std::string buffer;
+    const bool line_flush;
+    std::mutex mutex;
+
+    void flush_locked();
+
+public:
+    OutputWriter(std::ostream & stream_, bool line_flush_);
+    ~OutputWriter();
+
+    OutputWriter(const OutputWriter &) = delete;
+    OutputWriter & operator=(const OutputWriter &) = delete;
+
+    // append the parts and a newline as one line, throws if the stream fails on flushing
+    template < typename... Parts >
+    void line(const Parts &... parts)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        (buffer.append(std::string_view(parts)), ...);
+        buffer += '\n';
+        if (line_flush || buffer.size() >= flush_threshold) {
+            flush_locked();
+        }
+    }
+
+    // hand everything buffered to the stream and flush it
+    void flush();
+};
+
+#endif //OUTPUT_WRITER_H
@@ -0,0 +1,81 @@
+/* stats.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+/*
+ * Opt-in throughput and latency counters for --stats. Every thread owns its counters and only
+ * ever writes its own, with plain relaxed loads and stores, so the hot path takes no lock and
+ * no locked instruction; a report sums them all up, approximately while hashing is under way.
+ */
+namespace stats {
+    enum format_t { TEXT, JSON };
+
+    // parse a format given on the command line, throws on unknown names
+    format_t format_from_name(const std::string & name);
+
+    // start counting, before any worker thread is created; everything below is a no-op until then
+    void enable();
+    bool enabled();
+
+    // monotonic clock in ns
+    uint64_t now_ns();
+
+    // one read(2), pread(2) or io_uring_enter(2) issued by the calling thread
+    void count_read_call();
+
+    // length bytes of a file mapped into memory, page faults on them count as hashing, not as waiting for I/O
+    void count_mapped(uint64_t length);
+
+    // length bytes delivered to the digests, after io_wait_ns waiting for them and taking hash_ns to digest
+    void count_chunk(uint64_t length, uint64_t io_wait_ns, uint64_t hash_ns);
+
+    // a file finished, latency_ns after it was started
+    void count_file(uint64_t latency_ns);
+
+    // totals of all threads so far
+    std::string report(format_t format);
+
+    /*
+     * Prints report(format) to STDERR whenever the process receives SIGUSR1, and once more when
+     * destroyed. Create it before any other thread, they inherit SIGUSR1 blocked from this one.
+     */
+    class Reporter {
+    private:
+        format_t format;
+        std::thread thread;
+        std::atomic < bool > stopping { false };
+
+    public:
+        explicit Reporter(format_t format_);
+        ~Reporter();
+
+        Reporter(const Reporter &) = delete;
+        Reporter & operator=(const Reporter &) = delete;
+    };
+}
+
+#endif //STATS_H
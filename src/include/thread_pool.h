@@ -0,0 +1,126 @@
+/* thread_pool.h
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool {
+private:
+    std::vector < std::thread > workers;
+    std::queue < std::function < void() > > tasks;
+    std::mutex tasks_mutex;
+    std::condition_variable tasks_cv;
+    bool stopping = false;
+
+    void worker_loop();
+
+public:
+    // threads == 0 means one worker per hardware thread
+    explicit ThreadPool(unsigned int threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool & operator=(const ThreadPool &) = delete;
+
+    [[nodiscard]] unsigned int size() const {
+        return static_cast<unsigned int>(workers.size());
+    }
+
+    // queue a task, exceptions thrown by it are delivered through the returned future
+    template < typename Func >
+    std::future < std::invoke_result_t < Func > > submit(Func && func)
+    {
+        using result_t = std::invoke_result_t < Func >;
+        auto task = std::make_shared < std::packaged_task < result_t() > >(std::forward < Func >(func));
+        auto future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(tasks_mutex);
+            tasks.emplace([task]() { (*task)(); });
+        }
+        tasks_cv.notify_one();
+        return future;
+    }
+};
+
+// runs work() for every pushed item on a pool (or inline without one) and hands the results
+// to sink() on the calling thread in push order, keeping at most a few items per worker in flight
+template < typename Item, typename Result >
+class OrderedPipeline {
+public:
+    using work_t = std::function < Result(const Item &) >;
+    using sink_t = std::function < void(const Item &, Result) >;
+
+private:
+    ThreadPool * pool;
+    std::shared_ptr < const work_t > work; // shared with queued tasks, which may outlive the pipeline on errors
+    sink_t sink;
+    size_t window;
+    std::deque < std::pair < Item, std::future < Result > > > in_flight;
+
+    void drain_oldest()
+    {
+        auto [item, future] = std::move(in_flight.front());
+        in_flight.pop_front();
+        sink(item, future.get());
+    }
+
+public:
+    OrderedPipeline(ThreadPool * pool_, work_t work_, sink_t sink_)
+        : pool(pool_),
+          work(std::make_shared < const work_t >(std::move(work_))),
+          sink(std::move(sink_)),
+          window(pool_ ? pool_->size() * 4 : 0)
+    { }
+
+    void push(Item item)
+    {
+        if (!pool) {
+            sink(item, (*work)(item));
+            return;
+        }
+
+        auto future = pool->submit([work_ = work, item] { return (*work_)(item); });
+        in_flight.emplace_back(std::move(item), std::move(future));
+        if (in_flight.size() >= window) {
+            drain_oldest();
+        }
+    }
+
+    // wait for everything still in flight
+    void finish()
+    {
+        while (!in_flight.empty()) {
+            drain_oldest();
+        }
+    }
+};
+
+#endif //THREAD_POOL_H
@@ -0,0 +1,56 @@
+/* libcrc64.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "libcrc64.h"
+#include "crc64.h"
+
+void crc64_init(crc64_state_t * state)
+{
+    state->checksum = 0;
+}
+
+void crc64_update(crc64_state_t * state, const void * data, const size_t length)
+{
+    CRC64 crc64(state->checksum);
+    crc64.update(static_cast<const uint8_t *>(data), length);
+    state->checksum = crc64.get_checksum(LITTLE_ENDIAN);
+}
+
+void crc64_update_zeros(crc64_state_t * state, const uint64_t count)
+{
+    CRC64 crc64(state->checksum);
+    crc64.update_zeros(count);
+    state->checksum = crc64.get_checksum(LITTLE_ENDIAN);
+}
+
+uint64_t crc64_final(const crc64_state_t * state)
+{
+    return state->checksum;
+}
+
+uint64_t crc64_combine(const uint64_t checksum_a, const uint64_t checksum_b, const uint64_t length_b)
+{
+    return CRC64::combine(checksum_a, checksum_b, length_b);
+}
+
+const char * crc64_kernel_name(void)
+{
+    return CRC64::kernel_name();
+}
@@ -0,0 +1,348 @@
+/* manifest.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "manifest.h"
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#ifdef __unix__
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif // __unix__
+
+namespace manifest {
+    namespace {
+        constexpr char binary_magic[8] = { 'C', 'R', 'C', '6', '4', 'M', 'A', 'N' };
+        constexpr uint32_t binary_version = 1;
+
+        uint64_t to_le64(const uint64_t value)
+        {
+            if constexpr (std::endian::native == std::endian::big) {
+                return std::byteswap(value);
+            }
+            return value;
+        }
+
+        uint32_t to_le32(const uint32_t value)
+        {
+            if constexpr (std::endian::native == std::endian::big) {
+                return std::byteswap(value);
+            }
+            return value;
+        }
+
+        // the mapping is only 8 byte aligned in practice, read fields through memcpy
+        uint64_t field(const uint64_t & stored)
+        {
+            uint64_t value;
+            std::memcpy(&value, &stored, sizeof(value));
+            return to_le64(value);
+        }
+
+        // map a whole file read only, read it into buffer where that is not possible
+        const uint8_t * load_file(const std::string & filename, size_t & size, void *& map, std::string & buffer)
+        {
+#ifdef __unix__
+            if (const int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC); fd >= 0)
+            {
+                struct stat info { };
+                if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+                {
+                    size = static_cast<size_t>(info.st_size);
+                    map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (map != MAP_FAILED) {
+                        close(fd);
+                        return static_cast<const uint8_t *>(map);
+                    }
+                    map = nullptr;
+                }
+                close(fd);
+            }
+#endif // __unix__
+
+            // pipes, empty files and platforms without mmap
+            std::ifstream file_stream(filename, std::ios::in | std::ios::binary);
+            if (!file_stream) {
+                throw std::runtime_error("Could not open file: " + filename);
+            }
+
+            buffer.assign(std::istreambuf_iterator<char>(file_stream), std::istreambuf_iterator<char>());
+            if (file_stream.bad()) {
+                throw std::runtime_error("Cannot read file: " + filename);
+            }
+            size = buffer.size();
+            return reinterpret_cast<const uint8_t *>(buffer.data());
+        }
+
+        void unload_file(void * map, const size_t size)
+        {
+#ifdef __unix__
+            if (map) {
+                munmap(map, size);
+            }
+#endif // __unix__
+        }
+
+        // what --digest prints after the CRC64: space separated CRC-32C and xxHash64 values, 8 or 16 hex digits each
+        bool valid_digests(const std::string_view text)
+        {
+            size_t digits = 0;
+            for (const char ch : text)
+            {
+                const auto c = static_cast<unsigned char>(ch);
+                if (std::isxdigit(c)) {
+                    ++digits;
+                } else if (c == ' ' || !std::isprint(c)) {
+                    if (digits != 0 && digits != 8 && digits != 16) {
+                        return false;
+                    }
+                    digits = 0;
+                } else {
+                    return false;
+                }
+            }
+
+            return digits == 0 || digits == 8 || digits == 16;
+        }
+    }
+
+    bool parse_checksum(const std::string_view text, uint64_t & checksum)
+    {
+        // bytes in the order they are printed, which is their order in memory
+        uint8_t bytes[sizeof(uint64_t)] { };
+        size_t digits = 0;
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            const auto c = static_cast<unsigned char>(text[i]);
+            uint8_t nibble = 0;
+            if (c >= '0' && c <= '9') {
+                nibble = c - '0';
+            } else if (c >= 'a' && c <= 'f') {
+                nibble = c - 'a' + 10;
+            } else if (c >= 'A' && c <= 'F') {
+                nibble = c - 'A' + 10;
+            } else if (c == ' ' && digits == sizeof(bytes) * 2) {
+                // digests printed with --digest follow
+                if (!valid_digests(text.substr(i))) {
+                    return false;
+                }
+                break;
+            } else if (c == ' ' || !std::isprint(c)) {
+                continue;
+            } else {
+                return false;
+            }
+
+            if (digits == sizeof(bytes) * 2) {
+                return false;
+            }
+            bytes[digits / 2] = static_cast<uint8_t>(bytes[digits / 2] << 4 | nibble);
+            ++digits;
+        }
+
+        if (digits != sizeof(bytes) * 2) {
+            return false;
+        }
+
+        std::memcpy(&checksum, bytes, sizeof(checksum));
+        return true;
+    }
+
+    TextManifest::TextManifest(const std::string & filename)
+    {
+        data = reinterpret_cast<const char *>(load_file(filename, size, map, buffer));
+#ifdef __unix__
+        if (map) {
+            madvise(map, size, MADV_SEQUENTIAL);
+        }
+#endif // __unix__
+    }
+
+    TextManifest::~TextManifest()
+    {
+        unload_file(map, size);
+    }
+
+    void write_binary(const std::string & filename, std::vector < record_t > records)
+    {
+        std::ranges::stable_sort(records, [](const record_t & a, const record_t & b) { return a.filename < b.filename; });
+
+        BinaryManifest::header_t header { };
+        std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+        header.version = to_le32(binary_version);
+        header.record_size = to_le32(sizeof(BinaryManifest::disk_record_t));
+        header.record_count = to_le64(records.size());
+        header.records_offset = to_le64(sizeof(header));
+        header.arena_offset = to_le64(sizeof(header) + records.size() * sizeof(BinaryManifest::disk_record_t));
+
+        std::vector < BinaryManifest::disk_record_t > disk_records;
+        disk_records.reserve(records.size());
+        uint64_t arena_size = 0;
+        for (const auto & record : records)
+        {
+            disk_records.push_back(BinaryManifest::disk_record_t {
+                .filename_offset = to_le64(arena_size),
+                .filename_length = to_le64(record.filename.size()),
+                .size = to_le64(record.size),
+                .mtime_ns = to_le64(static_cast<uint64_t>(record.mtime_ns)),
+                .checksum = to_le64(record.checksum),
+            });
+            arena_size += record.filename.size();
+        }
+        header.arena_size = to_le64(arena_size);
+
+        const std::string temporary = filename + ".tmp";
+        {
+            std::ofstream file_stream(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+            if (!file_stream) {
+                throw std::runtime_error("Could not open file: " + temporary);
+            }
+
+            file_stream.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            file_stream.write(reinterpret_cast<const char *>(disk_records.data()),
+                static_cast<std::streamsize>(disk_records.size() * sizeof(BinaryManifest::disk_record_t)));
+            for (const auto & record : records) {
+                file_stream.write(record.filename.data(), static_cast<std::streamsize>(record.filename.size()));
+            }
+
+            if (!file_stream.flush()) {
+                throw std::runtime_error("Cannot write file: " + temporary);
+            }
+        }
+
+        if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+            throw std::runtime_error("Cannot write file: " + filename);
+        }
+    }
+
+    bool is_binary(const std::string & filename)
+    {
+        std::ifstream file_stream(filename, std::ios::in | std::ios::binary);
+        char magic[sizeof(binary_magic)] { };
+        return file_stream.read(magic, sizeof(magic)) && std::memcmp(magic, binary_magic, sizeof(magic)) == 0;
+    }
+
+    BinaryManifest::BinaryManifest(const std::string & filename)
+    {
+        data = load_file(filename, size, map, buffer);
+
+        header_t header { };
+        if (size >= sizeof(header)) {
+            std::memcpy(&header, data, sizeof(header));
+        }
+
+        const uint64_t count = to_le64(header.record_count);
+        const uint64_t records_offset = to_le64(header.records_offset);
+        const uint64_t arena_offset = to_le64(header.arena_offset);
+        arena_size = to_le64(header.arena_size);
+        if (size < sizeof(header)
+            || std::memcmp(header.magic, binary_magic, sizeof(binary_magic)) != 0
+            || to_le32(header.version) != binary_version
+            || to_le32(header.record_size) != sizeof(disk_record_t)
+            || records_offset > size
+            || count > (size - records_offset) / sizeof(disk_record_t)
+            || arena_offset > size
+            || arena_size > size - arena_offset)
+        {
+            unload_file(map, size);
+            errno = EINVAL;
+            throw std::runtime_error("Not a binary manifest: " + filename);
+        }
+
+        records = reinterpret_cast<const disk_record_t *>(data + records_offset);
+        record_count = count;
+        arena = reinterpret_cast<const char *>(data + arena_offset);
+        name = filename;
+    }
+
+    BinaryManifest::~BinaryManifest()
+    {
+        unload_file(map, size);
+    }
+
+    std::string_view BinaryManifest::filename(const uint64_t index) const
+    {
+        // checked here rather than on opening, so looking up a few records does not page in all of them
+        const uint64_t offset = field(records[index].filename_offset);
+        const uint64_t length = field(records[index].filename_length);
+        if (offset > arena_size || length > arena_size - offset) {
+            errno = EINVAL;
+            throw std::runtime_error("Corrupted binary manifest: " + name);
+        }
+        return { arena + offset, length };
+    }
+
+    uint64_t BinaryManifest::checksum(const uint64_t index) const
+    {
+        return field(records[index].checksum);
+    }
+
+    uint64_t BinaryManifest::file_size(const uint64_t index) const
+    {
+        return field(records[index].size);
+    }
+
+    int64_t BinaryManifest::mtime_ns(const uint64_t index) const
+    {
+        return static_cast<int64_t>(field(records[index].mtime_ns));
+    }
+
+    uint64_t BinaryManifest::lower_bound(const std::string_view filename) const
+    {
+        uint64_t first = 0;
+        uint64_t length = record_count;
+        while (length > 0)
+        {
+            const uint64_t half = length / 2;
+            if (this->filename(first + half) < filename) {
+                first += half + 1;
+                length -= half + 1;
+            } else {
+                length = half;
+            }
+        }
+        return first;
+    }
+
+    std::pair < uint64_t, uint64_t > BinaryManifest::select(const std::string_view path) const
+    {
+        const uint64_t first = lower_bound(path);
+        uint64_t last = first;
+        if (path.ends_with('/')) {
+            while (last < record_count && filename(last).starts_with(path)) {
+                ++last;
+            }
+        } else {
+            while (last < record_count && filename(last) == path) {
+                ++last;
+            }
+        }
+        return { first, last };
+    }
+}
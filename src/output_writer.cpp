@@ -0,0 +1,53 @@
+/* output_writer.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "output_writer.h"
+#include <stdexcept>
+
+OutputWriter::OutputWriter(std::ostream & stream_, const bool line_flush_)
+    : stream(stream_), line_flush(line_flush_)
+{
+    buffer.reserve(flush_threshold + 4096);
+}
+
+OutputWriter::~OutputWriter()
+{
+    try {
+        flush();
+    } catch (...) {
+        // nowhere left to report it, e.g., the reader of a pipe went away
+    }
+}
+
+void OutputWriter::flush_locked()
+{
+    stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    stream.flush();
+    buffer.clear();
+    if (!stream) {
+        throw std::runtime_error("Cannot write output");
+    }
+}
+
+void OutputWriter::flush()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    flush_locked();
+}
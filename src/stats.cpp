@@ -0,0 +1,302 @@
+/* stats.cpp
+ *
+ * Copyright 2025 Anivice Ives
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "stats.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+#ifdef __unix__
+# include <csignal>
+# include <pthread.h>
+# include <sys/resource.h>
+#endif // __unix__
+
+namespace stats {
+    namespace {
+        // latencies go to log-linear buckets, 8 per power of two, i.e., within 12.5% of the real value
+        constexpr unsigned int sub_bucket_bits = 3;
+        constexpr size_t bucket_count = (64 - sub_bucket_bits + 1) << sub_bucket_bits;
+
+        size_t bucket_of(const uint64_t ns)
+        {
+            const unsigned int width = std::bit_width(ns);
+            if (width <= sub_bucket_bits) {
+                return ns;
+            }
+            const unsigned int shift = width - sub_bucket_bits - 1;
+            return ((shift + 1) << sub_bucket_bits) + ((ns >> shift) & ((1 << sub_bucket_bits) - 1));
+        }
+
+        // the largest latency that falls into a bucket
+        uint64_t bucket_limit(const size_t bucket)
+        {
+            if (bucket < (1 << sub_bucket_bits)) {
+                return bucket;
+            }
+            const unsigned int shift = (bucket >> sub_bucket_bits) - 1;
+            const uint64_t base = (1ULL << sub_bucket_bits) | (bucket & ((1 << sub_bucket_bits) - 1));
+            return ((base + 1) << shift) - 1;
+        }
+
+        struct counters_t {
+            std::atomic < uint64_t > bytes { 0 };
+            std::atomic < uint64_t > read_calls { 0 };
+            std::atomic < uint64_t > mapped_bytes { 0 };
+            std::atomic < uint64_t > io_wait_ns { 0 };
+            std::atomic < uint64_t > hash_ns { 0 };
+            std::atomic < uint64_t > files { 0 };
+            std::atomic < uint64_t > latency_max_ns { 0 };
+            std::array < std::atomic < uint64_t >, bucket_count > latency { };
+        };
+
+        // only the owning thread writes, so a load and a store do, without a locked read-modify-write
+        void add(std::atomic < uint64_t > & counter, const uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        bool stats_enabled = false;
+        uint64_t started_ns = 0;
+        uint64_t started_major_faults = 0;
+
+        // page faults of the whole process that had to wait for the disk, 0 where unknown
+        uint64_t major_faults()
+        {
+#ifdef __unix__
+            if (rusage usage { }; getrusage(RUSAGE_SELF, &usage) == 0) {
+                return static_cast<uint64_t>(usage.ru_majflt);
+            }
+#endif // __unix__
+            return 0;
+        }
+
+        // counters of every thread that counted anything, kept after the thread exits
+        std::mutex registry_mutex;
+        std::deque < std::unique_ptr < counters_t > > registry;
+
+        counters_t & local_counters()
+        {
+            thread_local counters_t * counters = []
+            {
+                const std::lock_guard<std::mutex> lock(registry_mutex);
+                registry.push_back(std::make_unique < counters_t >());
+                return registry.back().get();
+            }();
+            return *counters;
+        }
+    }
+
+    format_t format_from_name(const std::string & name)
+    {
+        if (name == "text") {
+            return TEXT;
+        }
+
+        if (name == "json") {
+            return JSON;
+        }
+
+        throw std::runtime_error("Unknown stats format " + name);
+    }
+
+    void enable()
+    {
+        stats_enabled = true;
+        started_ns = now_ns();
+        started_major_faults = major_faults();
+    }
+
+    bool enabled()
+    {
+        return stats_enabled;
+    }
+
+    uint64_t now_ns()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void count_read_call()
+    {
+        if (stats_enabled) {
+            add(local_counters().read_calls, 1);
+        }
+    }
+
+    void count_mapped(const uint64_t length)
+    {
+        if (stats_enabled) {
+            add(local_counters().mapped_bytes, length);
+        }
+    }
+
+    void count_chunk(const uint64_t length, const uint64_t io_wait_ns, const uint64_t hash_ns)
+    {
+        if (!stats_enabled) {
+            return;
+        }
+
+        auto & counters = local_counters();
+        add(counters.bytes, length);
+        add(counters.io_wait_ns, io_wait_ns);
+        add(counters.hash_ns, hash_ns);
+    }
+
+    void count_file(const uint64_t latency_ns)
+    {
+        if (!stats_enabled) {
+            return;
+        }
+
+        auto & counters = local_counters();
+        add(counters.files, 1);
+        add(counters.latency[bucket_of(latency_ns)], 1);
+        if (latency_ns > counters.latency_max_ns.load(std::memory_order_relaxed)) {
+            counters.latency_max_ns.store(latency_ns, std::memory_order_relaxed);
+        }
+    }
+
+    std::string report(const format_t format)
+    {
+        uint64_t bytes = 0, read_calls = 0, mapped_bytes = 0, io_wait_ns = 0, hash_ns = 0, files = 0, latency_max_ns = 0;
+        std::array < uint64_t, bucket_count > latency { };
+        size_t threads = 0;
+        {
+            const std::lock_guard<std::mutex> lock(registry_mutex);
+            threads = registry.size();
+            for (const auto & counters : registry)
+            {
+                bytes += counters->bytes.load(std::memory_order_relaxed);
+                read_calls += counters->read_calls.load(std::memory_order_relaxed);
+                mapped_bytes += counters->mapped_bytes.load(std::memory_order_relaxed);
+                io_wait_ns += counters->io_wait_ns.load(std::memory_order_relaxed);
+                hash_ns += counters->hash_ns.load(std::memory_order_relaxed);
+                files += counters->files.load(std::memory_order_relaxed);
+                latency_max_ns = std::max(latency_max_ns, counters->latency_max_ns.load(std::memory_order_relaxed));
+                for (size_t i = 0; i < bucket_count; ++i) {
+                    latency[i] += counters->latency[i].load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // upper bound of the bucket holding the given fraction of all files, never above the maximum seen
+        auto percentile = [&](const double fraction)->uint64_t
+        {
+            const auto wanted = static_cast<uint64_t>(static_cast<double>(files) * fraction + 0.5);
+            uint64_t seen = 0;
+            for (size_t i = 0; i < bucket_count; ++i)
+            {
+                seen += latency[i];
+                if (seen >= std::max<uint64_t>(wanted, 1)) {
+                    return std::min(bucket_limit(i), latency_max_ns);
+                }
+            }
+            return latency_max_ns;
+        };
+
+        const uint64_t elapsed_ns = std::max<uint64_t>(now_ns() - started_ns, 1);
+        const double seconds = static_cast<double>(elapsed_ns) / 1e9;
+        const double files_per_second = static_cast<double>(files) / seconds;
+        const double bytes_per_second = static_cast<double>(bytes) / seconds;
+        const uint64_t p50 = files ? percentile(0.50) : 0;
+        const uint64_t p99 = files ? percentile(0.99) : 0;
+        const uint64_t faults = major_faults() - started_major_faults;
+        constexpr double mib = 1024 * 1024;
+
+        char text[1024] { };
+        if (format == JSON)
+        {
+            std::snprintf(text, sizeof(text),
+                "{\"elapsed_ns\": %llu, \"threads\": %zu, \"files\": %llu, \"bytes\": %llu, "
+                "\"files_per_second\": %.1f, \"bytes_per_second\": %.1f, \"read_calls\": %llu, "
+                "\"mapped_bytes\": %llu, \"major_faults\": %llu, \"io_wait_ns\": %llu, \"hash_ns\": %llu, "
+                "\"latency_ns\": {\"p50\": %llu, \"p99\": %llu, \"max\": %llu}}\n",
+                static_cast<unsigned long long>(elapsed_ns), threads,
+                static_cast<unsigned long long>(files), static_cast<unsigned long long>(bytes),
+                files_per_second, bytes_per_second, static_cast<unsigned long long>(read_calls),
+                static_cast<unsigned long long>(mapped_bytes), static_cast<unsigned long long>(faults),
+                static_cast<unsigned long long>(io_wait_ns), static_cast<unsigned long long>(hash_ns),
+                static_cast<unsigned long long>(p50), static_cast<unsigned long long>(p99),
+                static_cast<unsigned long long>(latency_max_ns));
+        }
+        else
+        {
+            // summed over all threads, so these can add up to more than the elapsed time;
+            // page faults on mapped files are spent inside hashing, so no verdict can be given then
+            const char * bound = !files && !bytes ? "idle"
+                : mapped_bytes ? "I/O wait not measured for mmap"
+                : io_wait_ns > hash_ns ? "I/O bound" : "CPU bound";
+            std::snprintf(text, sizeof(text),
+                "Stats: %llu files, %.1f MiB in %.3f s, %.1f files/s, %.1f MiB/s\n"
+                "Stats: %llu read calls, %.1f MiB mapped, %llu major page faults\n"
+                "Stats: %.3f s waiting for I/O, %.3f s hashing (%s, summed over %zu thread%s)\n"
+                "Stats: per-file latency p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                static_cast<unsigned long long>(files), static_cast<double>(bytes) / mib, seconds,
+                files_per_second, bytes_per_second / mib,
+                static_cast<unsigned long long>(read_calls), static_cast<double>(mapped_bytes) / mib,
+                static_cast<unsigned long long>(faults),
+                static_cast<double>(io_wait_ns) / 1e9, static_cast<double>(hash_ns) / 1e9, bound,
+                threads, threads == 1 ? "" : "s",
+                static_cast<double>(p50) / 1e6, static_cast<double>(p99) / 1e6,
+                static_cast<double>(latency_max_ns) / 1e6);
+        }
+
+        return text;
+    }
+
+    Reporter::Reporter(const format_t format_) : format(format_)
+    {
+        enable();
+#ifdef __unix__
+        // SIGUSR1 is only taken by sigwait() in the reporter thread, every thread created later inherits the mask
+        sigset_t signals;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGUSR1);
+        pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+        thread = std::thread([this, signals]
+        {
+            int signal = 0;
+            while (sigwait(&signals, &signal) == 0 && !stopping) {
+                std::cerr << report(format) << std::flush;
+            }
+        });
+#endif // __unix__
+    }
+
+    Reporter::~Reporter()
+    {
+#ifdef __unix__
+        stopping = true;
+        pthread_kill(thread.native_handle(), SIGUSR1);
+        thread.join();
+#endif // __unix__
+        std::cerr << report(format) << std::flush;
+    }
+}